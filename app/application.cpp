@@ -136,6 +136,7 @@ void Application::initButtons() {
         if (buttons[i].length() == 0)
             continue;
 
+        // "<pin>" toggles, "<pin>:<scene>" recalls a stored scene
         int pin = buttons[i].toInt();
         if (pin >= _lastToggles.size()) {
             debug_i("Pin %d is invalid. Max is %d", pin, _lastToggles.size() - 1);
@@ -144,6 +145,11 @@ void Application::initButtons() {
         debug_i("Configuring button: '%s'", buttons[i].c_str());
 
         _lastToggles[pin] = 0ul;
+        _buttonScenes[pin] = -1;
+        int sep = buttons[i].indexOf(':');
+        if (sep > 0) {
+            _buttonScenes[pin] = buttons[i].substring(sep + 1).toInt();
+        }
 
         attachInterrupt(pin,  std::bind(&Application::onButtonTogglePressed, this, pin), FALLING);
         pinMode(pin, INPUT_PULLUP);
@@ -162,6 +168,8 @@ void Application::startServices() {
 
 void Application::restart() {
     debug_i("Application::restart");
+    rgbwwctrl.saveEnergy();
+    rgbwwctrl.saveClockDrift();
     if (network.isApActive()) {
         network.stopAp();
         _systimer.initializeMs(500, TimerDelegate(&Application::restart, this)).startOnce();
@@ -173,6 +181,7 @@ void Application::reset() {
     debug_i("Application::reset");
     cfg.reset();
     rgbwwctrl.colorReset();
+    rgbwwctrl.resetEnergy();
     network.forgetWifi();
     delay(500);
     restart();
@@ -245,8 +254,14 @@ void Application::onButtonTogglePressed(int pin) {
     unsigned long now = millis();
     unsigned long diff = now - _lastToggles[pin];
     if (diff > cfg.general.buttons_debounce_ms) {  // debounce
-        debug_i("Button %d pressed - toggle", pin);
-        rgbwwctrl.toggle();
+        if (_buttonScenes[pin] >= 0) {
+            debug_i("Button %d pressed - scene %d", pin, _buttonScenes[pin]);
+            rgbwwctrl.recallScene(_buttonScenes[pin]);
+        }
+        else {
+            debug_i("Button %d pressed - toggle", pin);
+            rgbwwctrl.toggle();
+        }
         _lastToggles[pin] = now;
     }
     else {
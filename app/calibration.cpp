@@ -0,0 +1,26 @@
+#include <RGBWWCtrl.h>
+
+namespace {
+    int32_t toFixed(float v) {
+        // limit to a range where the products cannot overflow
+        v = constrain(v, -8.0f, 8.0f);
+        return static_cast<int32_t>(v * (1 << ColorCalibration::FracBits) + (v < 0 ? -0.5f : 0.5f));
+    }
+}
+
+void ColorCalibration::build(const float rgb[9], const float white[4]) {
+    const int32_t one = 1 << FracBits;
+    _identity = true;
+
+    for (unsigned i=0; i < 9; ++i) {
+        _rgb[i] = toFixed(rgb[i]);
+        if (_rgb[i] != ((i % 4 == 0) ? one : 0))
+            _identity = false;
+    }
+
+    for (unsigned i=0; i < 4; ++i) {
+        _white[i] = toFixed(white[i]);
+        if (_white[i] != ((i % 3 == 0) ? one : 0))
+            _identity = false;
+    }
+}
@@ -0,0 +1,87 @@
+#include <RGBWWCtrl.h>
+
+#include <math.h>
+#include <algorithm>
+
+namespace {
+    const float one = 1 << 12;
+
+    // approximation of the black body color, normalized to a maximum of 1
+    void kelvinToRgb(float kelvin, float& r, float& g, float& b) {
+        const float t = kelvin / 100.0f;
+        if (t <= 66.0f) {
+            r = 1.0f;
+            g = constrain((99.4708025861f * logf(t) - 161.1195681661f) / 255.0f, 0.0f, 1.0f);
+            b = (t <= 19.0f) ? 0.0f : constrain((138.5177312231f * logf(t - 10.0f) - 305.0447927307f) / 255.0f, 0.0f, 1.0f);
+        }
+        else {
+            r = constrain(329.698727446f * powf(t - 60.0f, -0.1332047592f) / 255.0f, 0.0f, 1.0f);
+            g = constrain(288.1221695283f * powf(t - 60.0f, -0.0755148492f) / 255.0f, 0.0f, 1.0f);
+            b = 1.0f;
+        }
+    }
+}
+
+void CctTable::build(int ww, int cw, int rgbAssist) {
+    const float miredWW = 1000000.0f / constrain(ww, 1000, 20000);
+    const float miredCW = 1000000.0f / constrain(cw, 1000, 20000);
+    const float assist = constrain(rgbAssist, 0, 100) / 100.0f;
+
+    for (unsigned i=0; i < Size; ++i) {
+        const float mired = MiredMin + i * MiredStep;
+        Entry& e = _table[i];
+
+        // outside the white range the tint fades in over 100 mired
+        float tint = 0.0f;
+        if (mired >= miredWW) {
+            e.ww = one;
+            tint = constrain((mired - miredWW) / 100.0f, 0.0f, 1.0f);
+        }
+        else if (mired <= miredCW) {
+            e.ww = 0;
+            tint = constrain((miredCW - mired) / 100.0f, 0.0f, 1.0f);
+        }
+        else {
+            e.ww = (mired - miredCW) / (miredWW - miredCW) * one + 0.5f;
+        }
+
+        // tint towards the requested color as seen from the nearest white LED
+        float r, g, b, lr, lg, lb;
+        kelvinToRgb(1000000.0f / mired, r, g, b);
+        kelvinToRgb((mired >= miredWW) ? ww : cw, lr, lg, lb);
+        r /= std::max(lr, 0.01f);
+        g /= std::max(lg, 0.01f);
+        b /= std::max(lb, 0.01f);
+        const float lo = std::min(r, std::min(g, b));
+        const float hi = std::max(r, std::max(g, b));
+        if (hi - lo > 0.001f) {
+            r = (r - lo) / (hi - lo);
+            g = (g - lo) / (hi - lo);
+            b = (b - lo) / (hi - lo);
+        }
+        else {
+            tint = 0.0f;
+        }
+        tint *= assist;
+        e.r = r * tint * one + 0.5f;
+        e.g = g * tint * one + 0.5f;
+        e.b = b * tint * one + 0.5f;
+    }
+}
+
+void CctTable::apply(int ct, ChannelOutput& output) const {
+    if (ct <= 0)
+        return;
+
+    const int mired = (ct > MiredMax) ? 1000000 / ct : ct;
+    const unsigned idx = (constrain(mired, MiredMin, MiredMax) - MiredMin) / MiredStep;
+    const Entry& e = _table[idx];
+
+    const int32_t white = output.ww + output.cw;
+    const int32_t ww = (white * e.ww) >> 12;
+    output.ww = std::min<int32_t>(ww, RGBWW_CALC_MAXVAL);
+    output.cw = std::min<int32_t>(white - ww, RGBWW_CALC_MAXVAL);
+    output.r = std::min<int32_t>(output.r + ((white * e.r) >> 12), RGBWW_CALC_MAXVAL);
+    output.g = std::min<int32_t>(output.g + ((white * e.g) >> 12), RGBWW_CALC_MAXVAL);
+    output.b = std::min<int32_t>(output.b + ((white * e.b) >> 12), RGBWW_CALC_MAXVAL);
+}
@@ -0,0 +1,148 @@
+#include <RGBWWCtrl.h>
+
+void ClockElection::start(const String& id) {
+    debug_i("ClockElection::start: id %s", id.c_str());
+    _id = id;
+    _masterId = "";
+    _role = Role::Follower;
+    // give a running master a full lease to show up before claiming
+    _lastHeartbeatMs = millis();
+    _synced = false;
+    _active = true;
+}
+
+void ClockElection::stop() {
+    _active = false;
+    _role = Role::Follower;
+    _masterId = "";
+}
+
+bool ClockElection::hasMaster() const {
+    return _active && _role != Role::Master && _masterId.length() > 0 &&
+            (millis() - _lastHeartbeatMs) < APP_CLOCKELECTION_LEASE_MS;
+}
+
+void ClockElection::onTick(uint32_t steps) {
+    if (!_active)
+        return;
+
+    const uint32_t now = millis();
+    switch (_role) {
+    case Role::Follower: {
+        uint32_t masterSteps;
+        if ((now - _lastHeartbeatMs) >= APP_CLOCKELECTION_LEASE_MS) {
+            debug_i("ClockElection: lease of '%s' expired", _masterId.c_str());
+            claim();
+        }
+        else if (_masterId.length() > 0 && _id < _masterId && app.rgbwwctrl.toMasterSteps(steps, masterSteps)) {
+            // preempt only once the timeline of the current master is followed
+            claim();
+        }
+        break;
+    }
+    case Role::Candidate:
+        if ((now - _claimMs) >= APP_CLOCKELECTION_CLAIM_MS)
+            promote();
+        break;
+    case Role::Master:
+        break;
+    }
+
+    if (_role == Role::Master)
+        app.mqttclient.publishElection("master", app.rgbwwctrl.getStepCounter());
+}
+
+void ClockElection::onMessage(const String& message) {
+    if (!_active)
+        return;
+
+    StaticJsonDocument<128> doc;
+    Json::deserialize(doc, message);
+
+    String id;
+    String role;
+    uint32_t steps = 0;
+    Json::getValue(doc["id"], id);
+    Json::getValue(doc["role"], role);
+    Json::getValue(doc["steps"], steps);
+
+    // the broker also delivers our own messages
+    if (id.length() == 0 || id == _id)
+        return;
+
+    if (role == "master") {
+        onHeartbeat(id, steps);
+    }
+    else if (role == "claim") {
+        if (id < _id) {
+            // the master answers claims of higher ids itself
+            if (hasMaster() && _masterId < id)
+                return;
+            // a lower id takes over, wait for its heartbeats
+            if (_role != Role::Follower)
+                debug_i("ClockElection: yielding to claim of '%s'", id.c_str());
+            follow(id);
+        }
+        else if (_role == Role::Master) {
+            // answer right away, before the claim window of the higher id ends
+            app.mqttclient.publishElection("master", app.rgbwwctrl.getStepCounter());
+        }
+    }
+}
+
+void ClockElection::onHeartbeat(const String& id, uint32_t steps) {
+    const uint32_t now = millis();
+    if (_role != Role::Follower) {
+        // our own heartbeats make the higher id step down
+        if (_id < id)
+            return;
+        debug_i("ClockElection: stepping down for '%s'", id.c_str());
+        follow(id);
+    }
+    else if (id != _masterId) {
+        // two masters for a moment while one steps down: stay with the lower id
+        const bool leaseExpired = (now - _lastHeartbeatMs) >= APP_CLOCKELECTION_LEASE_MS;
+        if (_masterId.length() > 0 && !leaseExpired && _masterId < id)
+            return;
+        follow(id);
+    }
+
+    _lastHeartbeatMs = now;
+
+    // the heartbeat is the master clock, the UDP clock is more precise if available.
+    // Like ClockUdp the step sync only gets one per clock_master_interval.
+    if (app.clockudp.isReceiving())
+        return;
+    const uint32_t intervalMs = app.cfg.sync.clock_master_interval * 1000;
+    if (_synced && (now - _lastSyncMs) + 500 < intervalMs)
+        return;
+
+    _synced = true;
+    _lastSyncMs = now;
+    app.rgbwwctrl.onMasterClock(steps);
+}
+
+void ClockElection::claim() {
+    debug_i("ClockElection: claiming the clock master role");
+    _role = Role::Candidate;
+    _claimMs = millis();
+    app.mqttclient.publishElection("claim");
+}
+
+void ClockElection::promote() {
+    debug_i("ClockElection: became clock master");
+    _role = Role::Master;
+    _masterId = _id;
+    app.rgbwwctrl.continueTimeline();
+}
+
+void ClockElection::follow(const String& id) {
+    if (id != _masterId) {
+        debug_i("ClockElection: following '%s'", id.c_str());
+        // sync right away with the first heartbeat of the new master
+        _synced = false;
+    }
+    _role = Role::Follower;
+    _masterId = id;
+    _lastHeartbeatMs = millis();
+}
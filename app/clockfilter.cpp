@@ -0,0 +1,32 @@
+#include <RGBWWCtrl.h>
+
+namespace {
+    // no network delays that long, the master restarted
+    const int32_t maxDelayJumpUs = 1000000;
+}
+
+bool ClockFilter::onPacket(uint32_t sendUs, uint32_t recvUs) {
+    const uint32_t delay = recvUs - sendUs;
+    if (_count == 0)
+        _base = delay;
+
+    int32_t rel = static_cast<int32_t>(delay - _base);
+    if (rel > maxDelayJumpUs || rel < -maxDelayJumpUs) {
+        _count = 0;
+        _base = delay;
+        rel = 0;
+    }
+
+    _delays[_pos] = rel;
+    _pos = (_pos + 1) % WindowSize;
+    if (_count < WindowSize)
+        ++_count;
+
+    int32_t minimum = rel;
+    for (unsigned i=0; i < _count; ++i)
+        minimum = std::min(minimum, _delays[i]);
+
+    // the first sync sets the phase reference for good, so wait until the minimum is known
+    _excess = rel - minimum;
+    return _count == WindowSize && _excess <= MaxExcessUs;
+}
@@ -0,0 +1,90 @@
+#include <RGBWWCtrl.h>
+#include <lwip/igmp.h>
+
+namespace {
+    const char clockMagic[3] = { 'R', 'W', 'C' };
+
+    inline void writeU32(uint8_t* p, uint32_t value) {
+        p[0] = value;
+        p[1] = value >> 8;
+        p[2] = value >> 16;
+        p[3] = value >> 24;
+    }
+
+    inline uint32_t readU32(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+}
+
+ClockUdp::~ClockUdp() {
+    stop();
+}
+
+void ClockUdp::start() {
+    if (_udp != nullptr)
+        return;
+
+    _group = IpAddress(app.cfg.sync.clock_udp_group);
+    debug_i("ClockUdp::start: %s:%d", _group.toString().c_str(), app.cfg.sync.clock_udp_port);
+
+    _udp = new UdpConnection(UdpConnectionDataDelegate(&ClockUdp::onReceive, this));
+    // with the election every device may become a slave
+    if (app.cfg.sync.clock_slave_enabled || app.cfg.sync.clock_election_enabled) {
+        ip_addr_t group = _group;
+        if (igmp_joingroup(IP_ADDR_ANY, &group) != ERR_OK)
+            debug_e("ClockUdp: joining multicast group failed");
+        _udp->listen(app.cfg.sync.clock_udp_port);
+    }
+
+    _filter.reset();
+    _synced = false;
+}
+
+void ClockUdp::stop() {
+    delete _udp;
+    _udp = nullptr;
+}
+
+void ClockUdp::sendClock(uint32_t steps, uint32_t stepUs) {
+    if (_udp == nullptr)
+        return;
+
+    uint8_t packet[_packetSize];
+    memcpy(packet, clockMagic, sizeof(clockMagic));
+    packet[3] = _version;
+    writeU32(packet + 4, steps);
+    writeU32(packet + 8, micros());
+    writeU32(packet + 12, stepUs);
+    _udp->sendTo(_group, app.cfg.sync.clock_udp_port, reinterpret_cast<const char*>(packet), sizeof(packet));
+}
+
+bool ClockUdp::isReceiving() const {
+    return _synced && (millis() - _lastGoodMs) < APP_CLOCKUDP_RECEIVE_TIMEOUT_MS;
+}
+
+void ClockUdp::onReceive(UdpConnection& connection, char* data, int size, IpAddress remoteIP, uint16_t remotePort) {
+    const uint32_t recvUs = micros();
+    const uint8_t* packet = reinterpret_cast<const uint8_t*>(data);
+    if (!app.rgbwwctrl.isClockSlave() || size != _packetSize ||
+            memcmp(packet, clockMagic, sizeof(clockMagic)) != 0 || packet[3] != _version)
+        return;
+
+    const uint32_t steps = readU32(packet + 4);
+    if (!_filter.onPacket(readU32(packet + 8), recvUs)) {
+        debug_d("ClockUdp: dropping delayed packet (+%d us)", _filter.getExcess());
+        return;
+    }
+
+    const uint32_t now = millis();
+    _lastGoodMs = now;
+
+    // the master sends every second, the step sync expects the configured interval.
+    // Half a second of slack, so a good packet close to the interval is not skipped.
+    const uint32_t intervalMs = app.cfg.sync.clock_master_interval * 1000;
+    if (_synced && (now - _lastSyncMs) + 500 < intervalMs)
+        return;
+
+    _synced = true;
+    _lastSyncMs = now;
+    app.rgbwwctrl.onMasterClock(steps, readU32(packet + 12), recvUs);
+}
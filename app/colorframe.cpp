@@ -0,0 +1,48 @@
+#include <RGBWWCtrl.h>
+
+namespace {
+    const char frameMagic[3] = { 'R', 'W', 'F' };
+
+    inline void writeU16(uint8_t* p, uint16_t value) {
+        p[0] = value;
+        p[1] = value >> 8;
+    }
+
+    inline void writeU32(uint8_t* p, uint32_t value) {
+        p[0] = value;
+        p[1] = value >> 8;
+        p[2] = value >> 16;
+        p[3] = value >> 24;
+    }
+
+    inline uint16_t readU16(const uint8_t* p) {
+        return p[0] | (p[1] << 8);
+    }
+
+    inline uint32_t readU32(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+}
+
+void ColorFrame::encode(uint8_t* buffer) const {
+    memcpy(buffer, frameMagic, sizeof(frameMagic));
+    buffer[3] = _version;
+    buffer[4] = mode;
+    buffer[5] = 0;
+    for (size_t i=0; i < NumValues; ++i)
+        writeU16(buffer + 6 + i * 2, values[i]);
+    writeU32(buffer + 16, step);
+}
+
+bool ColorFrame::decode(const uint8_t* buffer, size_t length) {
+    if (length != Size || memcmp(buffer, frameMagic, sizeof(frameMagic)) != 0 || buffer[3] != _version)
+        return false;
+    if (buffer[4] != Raw && buffer[4] != Hsv)
+        return false;
+
+    mode = buffer[4];
+    for (size_t i=0; i < NumValues; ++i)
+        values[i] = readU16(buffer + 6 + i * 2);
+    step = readU32(buffer + 16);
+    return true;
+}
@@ -0,0 +1,58 @@
+#include <RGBWWCtrl.h>
+
+namespace Easing {
+    const uint16_t tables[NumCurves - 1][65] = {
+        { // in
+            0, 16, 64, 144, 256, 400, 576, 784, 1024, 1296, 1600, 1936, 2304, 2704, 3136, 3600,
+            4096, 4624, 5184, 5776, 6400, 7056, 7744, 8464, 9216, 10000, 10816, 11664, 12544, 13456, 14400, 15376,
+            16384, 17424, 18496, 19600, 20736, 21904, 23104, 24336, 25600, 26896, 28224, 29584, 30976, 32400, 33855, 35343,
+            36863, 38415, 39999, 41615, 43263, 44943, 46655, 48399, 50175, 51983, 53823, 55695, 57599, 59535, 61503, 63503,
+            65535,
+        },
+        { // out
+            0, 2032, 4032, 6000, 7936, 9840, 11712, 13552, 15360, 17136, 18880, 20592, 22272, 23920, 25536, 27120,
+            28672, 30192, 31680, 33135, 34559, 35951, 37311, 38639, 39935, 41199, 42431, 43631, 44799, 45935, 47039, 48111,
+            49151, 50159, 51135, 52079, 52991, 53871, 54719, 55535, 56319, 57071, 57791, 58479, 59135, 59759, 60351, 60911,
+            61439, 61935, 62399, 62831, 63231, 63599, 63935, 64239, 64511, 64751, 64959, 65135, 65279, 65391, 65471, 65519,
+            65535,
+        },
+        { // in_out
+            0, 47, 188, 418, 736, 1137, 1620, 2180, 2816, 3523, 4300, 5142, 6048, 7013, 8036, 9112,
+            10240, 11415, 12636, 13898, 15200, 16537, 17908, 19308, 20736, 22187, 23660, 25150, 26656, 28173, 29700, 31232,
+            32768, 34303, 35835, 37362, 38879, 40385, 41875, 43348, 44799, 46227, 47627, 48998, 50335, 51637, 52899, 54120,
+            55295, 56423, 57499, 58522, 59487, 60393, 61235, 62012, 62719, 63355, 63915, 64398, 64799, 65117, 65347, 65488,
+            65535,
+        },
+        { // cie
+            0, 113, 227, 340, 453, 567, 686, 821, 972, 1141, 1328, 1535, 1762, 2010, 2281, 2575,
+            2894, 3237, 3607, 4004, 4429, 4883, 5367, 5882, 6429, 7009, 7623, 8272, 8956, 9677, 10436, 11234,
+            12071, 12948, 13868, 14830, 15835, 16885, 17980, 19121, 20310, 21547, 22833, 24170, 25558, 26997, 28490, 30037,
+            31639, 33297, 35012, 36785, 38616, 40507, 42460, 44473, 46550, 48690, 50895, 53166, 55503, 57907, 60380, 62922,
+            65535,
+        },
+        { // exp
+            0, 7, 15, 25, 35, 46, 59, 73, 88, 106, 125, 147, 171, 198, 228, 261,
+            298, 340, 386, 437, 495, 559, 630, 709, 798, 896, 1006, 1129, 1265, 1417, 1587, 1775,
+            1986, 2220, 2482, 2773, 3097, 3459, 3862, 4311, 4812, 5369, 5991, 6683, 7455, 8315, 9274, 10342,
+            11532, 12859, 14337, 15984, 17820, 19866, 22145, 24686, 27517, 30672, 34188, 38106, 42472, 47337, 52759, 58802,
+            65535,
+        },
+    };
+
+    Curve fromName(const String& name) {
+        if (name == "linear")
+            return Linear;
+        else if (name == "in")
+            return In;
+        else if (name == "out")
+            return Out;
+        else if (name == "in_out")
+            return InOut;
+        else if (name == "cie")
+            return Cie;
+        else if (name == "exp")
+            return Exp;
+        else
+            return NumCurves;
+    }
+}
@@ -0,0 +1,153 @@
+#include <RGBWWCtrl.h>
+
+#include <algorithm>
+
+namespace {
+    // first quarter of a sine wave, scaled to 65535
+    const uint16_t sineQuarter[65] = {
+        0, 1608, 3216, 4821, 6424, 8022, 9616, 11204, 12785, 14359, 15924, 17479, 19024, 20557, 22078, 23586,
+        25079, 26557, 28020, 29465, 30893, 32302, 33692, 35061, 36409, 37736, 39039, 40319, 41575, 42806, 44011, 45189,
+        46340, 47464, 48558, 49624, 50659, 51664, 52638, 53580, 54490, 55367, 56211, 57021, 57797, 58537, 59243, 59913,
+        60546, 61144, 61704, 62227, 62713, 63161, 63571, 63943, 64276, 64570, 64826, 65042, 65219, 65357, 65456, 65515,
+        65535,
+    };
+
+    inline int scale(int value, uint16_t level) {
+        return static_cast<int>((static_cast<uint32_t>(value) * level) >> 16);
+    }
+}
+
+void EffectEngine::start(const Params& params) {
+    _params = params;
+    if (_params.period == 0)
+        _params.period = 1;
+    if (_params.max < _params.min)
+        std::swap(_params.min, _params.max);
+    _periodSteps = std::max(_params.period / RGBWW_MINTIMEDIFF, 1u);
+
+    if (_params.channels == 0) {
+        _params.channels = (_params.effect == Effect::Rainbow) ? channelBit(CtrlChannel::Hue) : channelBit(CtrlChannel::Val);
+    }
+}
+
+void EffectEngine::stop() {
+    _params = Params();
+    _periodSteps = 1;
+}
+
+// phase 0..65535 is one full period, result is -65535..65535
+int32_t EffectEngine::sine(uint16_t phase) {
+    const unsigned quadrant = phase >> 14;
+    unsigned pos = phase & 0x3fff;
+    if (quadrant & 1)
+        pos = 0x4000 - pos;
+
+    // 64 table steps per quarter with linear interpolation in between
+    const unsigned idx = pos >> 8;
+    int32_t val = sineQuarter[idx];
+    if (idx < 64)
+        val += ((sineQuarter[idx + 1] - val) * static_cast<int32_t>(pos & 0xff)) >> 8;
+    return (quadrant & 2) ? -val : val;
+}
+
+uint16_t EffectEngine::noise(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return static_cast<uint16_t>(x);
+}
+
+uint16_t EffectEngine::waveform(uint32_t step) const {
+    const uint16_t phase = static_cast<uint16_t>((static_cast<uint64_t>(step % _periodSteps) << 16) / _periodSteps);
+
+    switch(_params.effect) {
+    case Effect::Rainbow:
+        return phase;
+    case Effect::Breathe:
+        // (1 - cos) / 2, starts at the lowest level
+        return static_cast<uint16_t>((65535 - sine(phase + 16384)) >> 1);
+    case Effect::Candle:
+    {
+        // value noise: interpolate between random levels once per period
+        const uint32_t segment = step / _periodSteps;
+        const int32_t a = noise(segment);
+        const int32_t b = noise(segment + 1);
+        return static_cast<uint16_t>(a + (((b - a) * static_cast<int32_t>(phase >> 1)) >> 15));
+    }
+    case Effect::Strobe:
+        return (phase < _params.duty) ? 65535 : 0;
+    default:
+        return 65535;
+    }
+}
+
+uint16_t EffectEngine::level(uint16_t wave) const {
+    return _params.min + ((static_cast<uint32_t>(wave) * (_params.max - _params.min)) >> 16);
+}
+
+void EffectEngine::apply(uint32_t step, HSVCT& color) const {
+    const uint16_t wave = waveform(step);
+    const ChannelMask channels = _params.channels;
+
+    if (channels & channelBit(CtrlChannel::Hue)) {
+        const int offset = (static_cast<uint32_t>(wave) * RGBWW_CALC_HUEWHEELMAX) >> 16;
+        color.h = (color.h + offset) % RGBWW_CALC_HUEWHEELMAX;
+    }
+
+    const uint16_t lvl = level(wave);
+    if (channels & channelBit(CtrlChannel::Sat))
+        color.s = scale(color.s, lvl);
+    if (channels & channelBit(CtrlChannel::Val))
+        color.v = scale(color.v, lvl);
+}
+
+void EffectEngine::apply(uint32_t step, ChannelOutput& output) const {
+    // raw mode has no hue, so every effect modulates the level of the scoped channels
+    ChannelMask channels = _params.channels;
+    if (channels & (channelBit(CtrlChannel::Hue) | channelBit(CtrlChannel::Sat) | channelBit(CtrlChannel::Val))) {
+        channels |= channelBit(CtrlChannel::Red) | channelBit(CtrlChannel::Green) | channelBit(CtrlChannel::Blue) |
+                channelBit(CtrlChannel::WarmWhite) | channelBit(CtrlChannel::ColdWhite);
+    }
+
+    const uint16_t lvl = level(waveform(step));
+    if (channels & channelBit(CtrlChannel::Red))
+        output.r = scale(output.r, lvl);
+    if (channels & channelBit(CtrlChannel::Green))
+        output.g = scale(output.g, lvl);
+    if (channels & channelBit(CtrlChannel::Blue))
+        output.b = scale(output.b, lvl);
+    if (channels & channelBit(CtrlChannel::WarmWhite))
+        output.ww = scale(output.ww, lvl);
+    if (channels & channelBit(CtrlChannel::ColdWhite))
+        output.cw = scale(output.cw, lvl);
+}
+
+EffectEngine::Effect EffectEngine::fromName(const String& name) {
+    if (name == "rainbow")
+        return Effect::Rainbow;
+    else if (name == "breathe")
+        return Effect::Breathe;
+    else if (name == "candle")
+        return Effect::Candle;
+    else if (name == "strobe")
+        return Effect::Strobe;
+    else
+        return Effect::None;
+}
+
+const char* EffectEngine::toName(Effect effect) {
+    switch(effect) {
+    case Effect::Rainbow:
+        return "rainbow";
+    case Effect::Breathe:
+        return "breathe";
+    case Effect::Candle:
+        return "candle";
+    case Effect::Strobe:
+        return "strobe";
+    default:
+        return "none";
+    }
+}
@@ -0,0 +1,65 @@
+#include <RGBWWCtrl.h>
+
+namespace {
+    // one mWh in mW * ms at full duty
+    const uint64_t mwhUnit = static_cast<uint64_t>(RGBWW_CALC_MAXVAL) * 3600 * 1000;
+}
+
+void EnergyMeter::configure(const uint32_t powerMw[NumChannels], uint32_t stepMs) {
+    _enabled = false;
+    for (unsigned i=0; i < NumChannels; ++i) {
+        _powerMw[i] = powerMw[i];
+        if (powerMw[i] > 0)
+            _enabled = true;
+    }
+    _stepMs = stepMs;
+    memset(_duty, 0, sizeof(_duty));
+}
+
+bool EnergyMeter::update() {
+    bool changed = false;
+    for (unsigned i=0; i < NumChannels; ++i) {
+        _rest[i] += static_cast<uint64_t>(_duty[i]) * _powerMw[i] * _stepMs;
+        _duty[i] = 0;
+        if (_rest[i] >= mwhUnit) {
+            _mwh[i] += _rest[i] / mwhUnit;
+            _rest[i] %= mwhUnit;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+uint32_t EnergyMeter::getTotalEnergy() const {
+    uint32_t total = 0;
+    for (unsigned i=0; i < NumChannels; ++i)
+        total += _mwh[i];
+    return total;
+}
+
+void EnergyMeter::load() {
+    StaticJsonDocument<128> doc;
+    if (!Json::loadFromFile(doc, APP_ENERGY_FILE))
+        return;
+
+    JsonArray mwh = doc["mwh"];
+    for (unsigned i=0; i < NumChannels && i < mwh.size(); ++i)
+        _mwh[i] = mwh[i];
+}
+
+void EnergyMeter::save() {
+    debug_d("Saving energy counters to file...");
+    StaticJsonDocument<128> doc;
+    JsonArray mwh = doc.createNestedArray("mwh");
+    for (unsigned i=0; i < NumChannels; ++i)
+        mwh.add(_mwh[i]);
+    Json::saveToFile(doc, APP_ENERGY_FILE);
+}
+
+void EnergyMeter::reset() {
+    memset(_duty, 0, sizeof(_duty));
+    memset(_rest, 0, sizeof(_rest));
+    memset(_mwh, 0, sizeof(_mwh));
+    if (fileExist(APP_ENERGY_FILE))
+        fileDelete(APP_ENERGY_FILE);
+}
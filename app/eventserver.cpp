@@ -73,13 +73,26 @@ void EventServer::publishCurrentState(const ChannelOutput& raw, const HSVCT* pHs
     sendToClients(msg);
 }
 
-void EventServer::publishClockSlaveStatus(int offset, uint32_t interval) {
+void EventServer::publishClockSlaveStatus(int offset, uint32_t interval, int driftPpm, bool locked) {
     debug_d("EventServer::publishClockSlaveStatus: offset: %d | interval :%d\n", offset, interval);
 
     JsonRpcMessage msg("clock_slave_status");
     JsonObject root = msg.getParams();
     root["offset"] = offset;
     root["current_interval"] = interval;
+    root["drift_ppm"] = driftPpm;
+    root["locked"] = locked;
+    sendToClients(msg);
+}
+
+void EventServer::publishPowerStatus(uint32_t currentMa, uint32_t powerMw, bool limited) {
+    debug_d("EventServer::publishPowerStatus: %u mA\n", currentMa);
+
+    JsonRpcMessage msg("power_status");
+    JsonObject root = msg.getParams();
+    root["current_ma"] = currentMa;
+    root["power_mw"] = powerMw;
+    root["limited"] = limited;
     sendToClients(msg);
 }
 
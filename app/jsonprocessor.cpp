@@ -1,14 +1,78 @@
 #include <RGBWWCtrl.h>
 
+namespace {
+    struct ChannelName {
+        const char* name;
+        CtrlChannel channel;
+    };
+
+    const ChannelName channelNames[] = {
+        { "h", CtrlChannel::Hue },
+        { "s", CtrlChannel::Sat },
+        { "v", CtrlChannel::Val },
+        { "ct", CtrlChannel::ColorTemp },
+        { "r", CtrlChannel::Red },
+        { "g", CtrlChannel::Green },
+        { "b", CtrlChannel::Blue },
+        { "ww", CtrlChannel::WarmWhite },
+        { "cw", CtrlChannel::ColdWhite },
+    };
+
+    const CtrlChannel hsvStepChannels[] = { CtrlChannel::Hue, CtrlChannel::Sat, CtrlChannel::Val, CtrlChannel::ColorTemp };
+    const CtrlChannel rawStepChannels[] = { CtrlChannel::Red, CtrlChannel::Green, CtrlChannel::Blue, CtrlChannel::WarmWhite, CtrlChannel::ColdWhite };
+
+    void appendU16(String& program, uint16_t value) {
+        program += static_cast<char>(value & 0xff);
+        program += static_cast<char>(value >> 8);
+    }
+
+    void appendU32(String& program, uint32_t value) {
+        appendU16(program, value & 0xffff);
+        appendU16(program, value >> 16);
+    }
+}
 
 bool JsonProcessor::onColor(const String& json, String& msg, bool relay) {
     debug_e("JsonProcessor::onColor: %s", json.c_str());
+
+    // relaying needs the JSON tree, so the cache is only usable for local execution
+    const bool needsTree = relay && app.cfg.sync.cmd_master_enabled;
+    if (!needsTree) {
+        const RequestParameters* pParams = _paramsCache.get(json);
+        if (pParams != nullptr)
+            return queueColorCommand(*pParams, msg);
+    }
+
     StaticJsonDocument<256> doc;
     Json::deserialize(doc, json);
-    return onColor(doc.as<JsonObject>(), msg, relay);
+    JsonObject root = doc.as<JsonObject>();
+    if (!root["cmds"].isNull())
+        return onColor(root, msg, relay);
+
+    // a payload with "at" must go through the scheduling every time, even if it ran right away now
+    const bool cacheable = root["at"].isNull();
+    if (deferCommand("color", root, relay))
+        return true;
+
+    bool result = false;
+    RequestParameters params;
+    parseRequestParams(root, params);
+    if (params.checkParams(msg) == 0) {
+        if (cacheable)
+            _paramsCache.put(json, params);
+        result = queueColorCommand(params, msg);
+    }
+
+    if (relay)
+        app.onCommandRelay("color", root);
+
+    return result;
 }
 
 bool JsonProcessor::onColor(JsonObject root, String& msg, bool relay) {
+    if (deferCommand("color", root, relay))
+        return true;
+
     bool result = false;
     auto cmds = root["cmds"].as<JsonArray>();
     if (!cmds.isNull()) {
@@ -51,8 +115,12 @@ bool JsonProcessor::onStop(const String& json, String& msg, bool relay) {
 bool JsonProcessor::onStop(JsonObject root, String& msg, bool relay) {
     RequestParameters params;
     JsonProcessor::parseRequestParams(root, params);
-    app.rgbwwctrl.clearAnimationQueue(params.channels);
-    app.rgbwwctrl.skipAnimation(params.channels);
+    _scheduled.clear();
+    app.rgbwwctrl.stopEffect();
+    app.rgbwwctrl.stopTransition();
+    app.rgbwwctrl.stopSequence();
+    app.rgbwwctrl.clearAnimationQueue(toChannelList(params.channels));
+    app.rgbwwctrl.skipAnimation(toChannelList(params.channels));
 
     onDirect(root, msg, false);
 
@@ -73,7 +141,7 @@ bool JsonProcessor::onSkip(const String& json, String& msg, bool relay) {
 bool JsonProcessor::onSkip(JsonObject root, String& msg, bool relay) {
     RequestParameters params;
     JsonProcessor::parseRequestParams(root, params);
-    app.rgbwwctrl.skipAnimation(params.channels);
+    app.rgbwwctrl.skipAnimation(toChannelList(params.channels));
 
     onDirect(root, msg, false);
 
@@ -95,7 +163,7 @@ bool JsonProcessor::onPause(JsonObject root, String& msg, bool relay) {
     RequestParameters params;
     JsonProcessor::parseRequestParams(root, params);
 
-    app.rgbwwctrl.pauseAnimation(params.channels);
+    app.rgbwwctrl.pauseAnimation(toChannelList(params.channels));
 
     onDirect(root, msg, false);
 
@@ -116,7 +184,7 @@ bool JsonProcessor::onContinue(const String& json, String& msg, bool relay) {
 bool JsonProcessor::onContinue(JsonObject root, String& msg, bool relay) {
     RequestParameters params;
     JsonProcessor::parseRequestParams(root, params);
-    app.rgbwwctrl.continueAnimation(params.channels);
+    app.rgbwwctrl.continueAnimation(toChannelList(params.channels));
 
     if (relay)
         app.onCommandRelay("continue", root);
@@ -131,12 +199,18 @@ bool JsonProcessor::onBlink(const String& json, String& msg, bool relay) {
 }
 
 bool JsonProcessor::onBlink(JsonObject root, String& msg, bool relay) {
+    if (deferCommand("blink", root, relay))
+        return true;
+
     RequestParameters params;
     params.ramp.value = 500; //default
 
     JsonProcessor::parseRequestParams(root, params);
 
-    app.rgbwwctrl.blink(params.channels, params.ramp.value, params.queue, params.requeue, params.name);
+    // a blink is queued like a fade, a running transition or sequence would override it
+    app.rgbwwctrl.stopTransition();
+    app.rgbwwctrl.stopSequence();
+    app.rgbwwctrl.blink(toChannelList(params.channels), params.ramp.value, params.queue, params.requeue, params.name);
 
     if (relay)
         app.onCommandRelay("blink", root);
@@ -151,6 +225,9 @@ bool JsonProcessor::onToggle(const String& json, String& msg, bool relay) {
 }
 
 bool JsonProcessor::onToggle(JsonObject root, String& msg, bool relay) {
+    if (deferCommand("toggle", root, relay))
+        return true;
+
     app.rgbwwctrl.toggle();
 
     if (relay)
@@ -159,6 +236,367 @@ bool JsonProcessor::onToggle(JsonObject root, String& msg, bool relay) {
     return true;
 }
 
+bool JsonProcessor::onEffect(const String& json, String& msg, bool relay) {
+    StaticJsonDocument<256> doc;
+    Json::deserialize(doc, json);
+    return onEffect(doc.as<JsonObject>(), msg, relay);
+}
+
+bool JsonProcessor::onEffect(JsonObject root, String& msg, bool relay) {
+    if (deferCommand("effect", root, relay))
+        return true;
+
+    String name;
+    if (!Json::getValue(root["effect"], name)) {
+        msg = "Missing effect";
+        return false;
+    }
+
+    EffectEngine::Params params;
+    params.effect = EffectEngine::fromName(name);
+    if (params.effect == EffectEngine::Effect::None) {
+        if (name != "none") {
+            msg = "Unknown effect";
+            return false;
+        }
+        app.rgbwwctrl.stopEffect();
+    }
+    else {
+        // levels are given in percent like HSV values
+        int percent;
+        Json::getValue(root["period"], params.period);
+        if (Json::getValue(root["min"], percent))
+            params.min = constrain(percent, 0, 100) * 65535 / 100;
+        if (Json::getValue(root["max"], percent))
+            params.max = constrain(percent, 0, 100) * 65535 / 100;
+        if (Json::getValue(root["duty"], percent))
+            params.duty = constrain(percent, 0, 100) * 65535 / 100;
+        params.channels = parseChannels(root["channels"]);
+
+        app.rgbwwctrl.startEffect(params);
+    }
+
+    if (relay)
+        app.onCommandRelay("effect", root);
+
+    return true;
+}
+
+bool JsonProcessor::onScene(const String& json, String& msg, bool relay) {
+    StaticJsonDocument<64> doc;
+    Json::deserialize(doc, json);
+    return onScene(doc.as<JsonObject>(), msg, relay);
+}
+
+bool JsonProcessor::onScene(JsonObject root, String& msg, bool relay) {
+    if (deferCommand("scene", root, relay))
+        return true;
+
+    int id;
+    if (!Json::getValue(root["scene"], id) || id < 0 || id >= APP_SCENES_MAX) {
+        msg = "Invalid scene";
+        return false;
+    }
+
+    if (!app.rgbwwctrl.recallScene(id)) {
+        msg = "Scene not found";
+        return false;
+    }
+
+    if (relay)
+        app.onCommandRelay("scene", root);
+
+    return true;
+}
+
+bool JsonProcessor::onSceneSave(JsonObject root, String& msg) {
+    int id;
+    if (!Json::getValue(root["id"], id) || id < 0 || id >= APP_SCENES_MAX) {
+        msg = "Invalid scene id";
+        return false;
+    }
+
+    bool remove;
+    if (Json::getBoolTolerant(root["delete"], remove) && remove) {
+        return app.rgbwwctrl.sceneStorage.remove(id);
+    }
+
+    Scene scene;
+    scene.used = 1;
+    String name;
+    if (Json::getValue(root["name"], name))
+        strncpy(scene.name, name.c_str(), sizeof(scene.name) - 1);
+
+    JsonArray cmds = root["cmds"];
+    if (!cmds.isNull()) {
+        if (cmds.size() == 0 || cmds.size() > APP_SCENE_MAXSTEPS) {
+            msg = "Invalid number of scene steps";
+            return false;
+        }
+        for (unsigned i=0; i < cmds.size(); ++i) {
+            if (!toSceneStep(cmds[i], scene.steps[i], msg))
+                return false;
+        }
+        scene.numSteps = cmds.size();
+    }
+    else {
+        if (!toSceneStep(root, scene.steps[0], msg))
+            return false;
+        scene.numSteps = 1;
+    }
+
+    if (!app.rgbwwctrl.sceneStorage.save(id, scene)) {
+        msg = "Saving scene failed";
+        return false;
+    }
+    return true;
+}
+
+bool JsonProcessor::onSequence(const String& json, String& msg, bool relay) {
+    StaticJsonDocument<128> doc;
+    Json::deserialize(doc, json);
+    return onSequence(doc.as<JsonObject>(), msg, relay);
+}
+
+bool JsonProcessor::onSequence(JsonObject root, String& msg, bool relay) {
+    if (deferCommand("sequence", root, relay))
+        return true;
+
+    String name;
+    bool stop;
+    if (Json::getValue(root["play"], name)) {
+        if (!app.rgbwwctrl.startSequence(name)) {
+            msg = "Sequence not found";
+            return false;
+        }
+    }
+    else if (Json::getBoolTolerant(root["stop"], stop) && stop) {
+        app.rgbwwctrl.stopSequence();
+    }
+    else {
+        msg = "Missing play or stop";
+        return false;
+    }
+
+    if (relay)
+        app.onCommandRelay("sequence", root);
+
+    return true;
+}
+
+bool JsonProcessor::onSequenceSave(JsonObject root, String& msg) {
+    String name;
+    if (!Json::getValue(root["name"], name)) {
+        msg = "Missing sequence name";
+        return false;
+    }
+
+    JsonArray ops = root["ops"];
+    if (ops.isNull()) {
+        msg = "Missing ops";
+        return false;
+    }
+
+    String program;
+    if (!compileSequence(ops, program, msg))
+        return false;
+
+    // the player keeps the file open while playing
+    const SequencePlayer& sequence = app.rgbwwctrl.getSequence();
+    if (sequence.isActive() && sequence.getName() == name)
+        app.rgbwwctrl.stopSequence();
+
+    return SequencePlayer::store(name, program, msg);
+}
+
+bool JsonProcessor::compileSequence(JsonArray ops, String& program, String& errorMsg) {
+    SequencePlayer::writeHeader(program);
+
+    // a channels instruction is only emitted when the set of given values changes
+    int lastChannels = -1;
+    for (JsonObject op : ops) {
+        uint32_t ms;
+        int count;
+        String ease;
+        if (!op["hsv"].isNull() || !op["raw"].isNull()) {
+            SceneStep step;
+            if (!toSceneStep(op, step, errorMsg))
+                return false;
+
+            const CtrlChannel* stepChannels = (step.mode == SceneStep::Hsv) ? hsvStepChannels : rawStepChannels;
+            const unsigned numValues = (step.mode == SceneStep::Hsv) ? 4 : 5;
+            ChannelMask channels = 0;
+            for (unsigned i=0; i < numValues; ++i) {
+                if (step.mask & (1 << i))
+                    channels |= channelBit(stepChannels[i]);
+            }
+
+            if (channels != lastChannels) {
+                program += static_cast<char>(SequencePlayer::Channels);
+                appendU16(program, channels);
+                lastChannels = channels;
+            }
+
+            // a solid color is set at once and then kept for the ramp time
+            program += static_cast<char>((step.mode == SceneStep::Hsv) ? SequencePlayer::FadeHsv : SequencePlayer::FadeRaw);
+            for (unsigned i=0; i < numValues; ++i)
+                appendU16(program, step.values[i]);
+            appendU32(program, step.fade ? step.ramp : 0);
+            if (!step.fade && step.ramp > 0) {
+                program += static_cast<char>(SequencePlayer::Hold);
+                appendU32(program, step.ramp);
+            }
+        }
+        else if (Json::getValue(op["hold"], ms)) {
+            program += static_cast<char>(SequencePlayer::Hold);
+            appendU32(program, ms);
+        }
+        else if (Json::getValue(op["loop"], count)) {
+            program += static_cast<char>(SequencePlayer::Loop);
+            appendU16(program, constrain(count, 0, 0xffff));
+        }
+        else if (!op["end_loop"].isNull()) {
+            program += static_cast<char>(SequencePlayer::EndLoop);
+        }
+        else if (Json::getValue(op["ease"], ease)) {
+            const Easing::Curve curve = Easing::fromName(ease);
+            if (curve == Easing::NumCurves) {
+                errorMsg = "Unknown easing";
+                return false;
+            }
+            program += static_cast<char>(SequencePlayer::Ease);
+            program += static_cast<char>(curve);
+        }
+        else {
+            errorMsg = "Unknown sequence op";
+            return false;
+        }
+
+        if (program.length() >= APP_SEQUENCE_MAXSIZE) {
+            errorMsg = "Sequence too long";
+            return false;
+        }
+    }
+
+    program += static_cast<char>(SequencePlayer::End);
+    return true;
+}
+
+bool JsonProcessor::toSceneStep(JsonObject root, SceneStep& step, String& errorMsg) {
+    RequestParameters params;
+    parseRequestParams(root, params);
+    if (params.checkParams(errorMsg) != 0)
+        return false;
+
+    if (params.hasHsvFrom || params.hasRawFrom) {
+        errorMsg = "'from' is not supported for stored commands";
+        return false;
+    }
+
+    // scene values are stored resolved, so relative values cannot be kept
+    if (params.relative) {
+        errorMsg = "Stored commands need absolute values";
+        return false;
+    }
+
+    // the stored ramp is a time, a speed would be replayed as ms
+    if (params.ramp.type != RampTimeOrSpeed::Type::Time) {
+        errorMsg = "Stored commands need a ramp time ('t')";
+        return false;
+    }
+
+    step.fade = (params.cmd == "fade");
+    step.direction = params.direction;
+    step.ramp = params.ramp.value;
+    step.mask = 0;
+
+    const AbsOrRelValue* values[5];
+    if (params.mode == RequestParameters::Mode::Hsv) {
+        step.mode = SceneStep::Hsv;
+        values[0] = &params.hsv.h;
+        values[1] = &params.hsv.s;
+        values[2] = &params.hsv.v;
+        values[3] = &params.hsv.ct;
+        values[4] = nullptr;
+    }
+    else if (params.mode == RequestParameters::Mode::Raw) {
+        step.mode = SceneStep::Raw;
+        values[0] = &params.raw.r;
+        values[1] = &params.raw.g;
+        values[2] = &params.raw.b;
+        values[3] = &params.raw.ww;
+        values[4] = &params.raw.cw;
+    }
+    else {
+        errorMsg = "No color object!";
+        return false;
+    }
+
+    for (unsigned i=0; i < 5; ++i) {
+        if (values[i] != nullptr && values[i]->hasValue()) {
+            step.values[i] = static_cast<int>(*values[i]);
+            step.mask |= (1 << i);
+        }
+    }
+    return true;
+}
+
+void JsonProcessor::startTransition(const RequestParameters& params) {
+    ChannelMask channels = 0;
+    if (params.mode == RequestParameters::Mode::Hsv) {
+        HSVCT to = app.rgbwwctrl.getCurrentColor();
+        if (params.hsv.h.hasValue()) {
+            to.h = params.hsv.h;
+            channels |= channelBit(CtrlChannel::Hue);
+        }
+        if (params.hsv.s.hasValue()) {
+            to.s = params.hsv.s;
+            channels |= channelBit(CtrlChannel::Sat);
+        }
+        if (params.hsv.v.hasValue()) {
+            to.v = params.hsv.v;
+            channels |= channelBit(CtrlChannel::Val);
+        }
+        if (params.hsv.ct.hasValue()) {
+            to.ct = params.hsv.ct;
+            channels |= channelBit(CtrlChannel::ColorTemp);
+        }
+
+        if (params.cmd == "fade_oklab")
+            app.rgbwwctrl.fadeOklab(to, params.ramp.value, params.ease, params.name);
+        else
+            app.rgbwwctrl.fadeEased(to, params.ramp.value, params.ease, channels, params.direction, params.name);
+    }
+    else {
+        ChannelOutput to = app.rgbwwctrl.getCurrentOutput();
+        if (params.raw.r.hasValue()) {
+            to.r = params.raw.r;
+            channels |= channelBit(CtrlChannel::Red);
+        }
+        if (params.raw.g.hasValue()) {
+            to.g = params.raw.g;
+            channels |= channelBit(CtrlChannel::Green);
+        }
+        if (params.raw.b.hasValue()) {
+            to.b = params.raw.b;
+            channels |= channelBit(CtrlChannel::Blue);
+        }
+        if (params.raw.ww.hasValue()) {
+            to.ww = params.raw.ww;
+            channels |= channelBit(CtrlChannel::WarmWhite);
+        }
+        if (params.raw.cw.hasValue()) {
+            to.cw = params.raw.cw;
+            channels |= channelBit(CtrlChannel::ColdWhite);
+        }
+
+        if (params.cmd == "fade_oklab")
+            app.rgbwwctrl.fadeOklab(to, params.ramp.value, params.ease, params.name);
+        else
+            app.rgbwwctrl.fadeEased(to, params.ramp.value, params.ease, channels, params.name);
+    }
+}
+
 bool JsonProcessor::onSingleColorCommand(JsonObject root, String& errorMsg) {
     RequestParameters params;
     parseRequestParams(root, params);
@@ -166,6 +604,19 @@ bool JsonProcessor::onSingleColorCommand(JsonObject root, String& errorMsg) {
         return false;
     }
 
+    return queueColorCommand(params, errorMsg);
+}
+
+bool JsonProcessor::queueColorCommand(const RequestParameters& params, String& errorMsg) {
+    if (params.isTransition()) {
+        startTransition(params);
+        return true;
+    }
+
+    // a queued command takes over from a running transition or sequence
+    app.rgbwwctrl.stopTransition();
+    app.rgbwwctrl.stopSequence();
+
     bool queueOk = false;
     if (params.mode == RequestParameters::Mode::Hsv) {
         if(!params.hasHsvFrom) {
@@ -207,6 +658,10 @@ bool JsonProcessor::onDirect(JsonObject root, String& msg, bool relay) {
     RequestParameters params;
     JsonProcessor::parseRequestParams(root, params);
 
+    // a direct color takes over from a running transition or sequence
+    app.rgbwwctrl.stopTransition();
+    app.rgbwwctrl.stopSequence();
+
     if (params.mode == RequestParameters::Mode::Hsv) {
         app.rgbwwctrl.colorDirectHSV(params.hsv);
     } else if (params.mode == RequestParameters::Mode::Raw) {
@@ -227,6 +682,7 @@ void JsonProcessor::parseRequestParams(JsonObject root, RequestParameters& param
 	JsonObject hsv = root["hsv"];
 	if (!hsv.isNull()) {
     	params.mode = RequestParameters::Mode::Hsv;
+        params.relative = hasRelativeValues(hsv);
         if (Json::getValue(hsv["h"], value))
             params.hsv.h = AbsOrRelValue(value, AbsOrRelValue::Type::Hue);
         if (Json::getValue(hsv["s"], value))
@@ -252,6 +708,7 @@ void JsonProcessor::parseRequestParams(JsonObject root, RequestParameters& param
     else if (!root["raw"].isNull()) {
     	JsonObject raw = root["raw"];
         params.mode = RequestParameters::Mode::Raw;
+        params.relative = hasRelativeValues(raw);
         if (Json::getValue(raw["r"], value))
             params.raw.r = AbsOrRelValue(value, AbsOrRelValue::Type::Raw);
         if (Json::getValue(raw["g"], value))
@@ -312,39 +769,40 @@ void JsonProcessor::parseRequestParams(JsonObject root, RequestParameters& param
         }
     }
 
+    params.channels = parseChannels(root["channels"]);
+
+    String ease;
+    if (Json::getValue(root["ease"], ease))
+        params.ease = Easing::fromName(ease);
+}
+
+bool JsonProcessor::hasRelativeValues(JsonObject color) {
+    for (JsonPair kv : color) {
+        const char* str = kv.value().as<const char*>();
+        if (str != nullptr && (str[0] == '+' || str[0] == '-'))
+            return true;
+    }
+    return false;
+}
+
+ChannelMask JsonProcessor::parseChannels(JsonVariant var) {
+    ChannelMask channels = 0;
     JsonArray arr;
-    if (Json::getValue(root["channels"], arr)) {
+    if (Json::getValue(var, arr)) {
         for(size_t i=0; i < arr.size(); ++i) {
-            String str = arr[i];
-            if (str == "h") {
-                params.channels.add(CtrlChannel::Hue);
-            }
-            else if (str == "s") {
-                params.channels.add(CtrlChannel::Sat);
-            }
-            else if (str == "v") {
-                params.channels.add(CtrlChannel::Val);
-            }
-            else if (str == "ct") {
-                params.channels.add(CtrlChannel::ColorTemp);
-            }
-            else if (str == "r") {
-                params.channels.add(CtrlChannel::Red);
-            }
-            else if (str == "g") {
-                params.channels.add(CtrlChannel::Green);
-            }
-            else if (str == "b") {
-                params.channels.add(CtrlChannel::Blue);
-            }
-            else if (str == "ww") {
-                params.channels.add(CtrlChannel::WarmWhite);
-            }
-            else if (str == "cw") {
-                params.channels.add(CtrlChannel::ColdWhite);
+            const char* str = arr[i];
+            if (str == nullptr)
+                continue;
+
+            for(const auto& entry : channelNames) {
+                if (strcmp(str, entry.name) == 0) {
+                    channels |= channelBit(entry.channel);
+                    break;
+                }
             }
         }
     }
+    return channels;
 }
 
 int JsonProcessor::RequestParameters::checkParams(String& errorMsg) const {
@@ -373,7 +831,7 @@ int JsonProcessor::RequestParameters::checkParams(String& errorMsg) const {
         return 1;
     }
 
-    if (cmd != "fade" && cmd != "solid") {
+    if (cmd != "fade" && cmd != "fade_oklab" && cmd != "solid") {
         errorMsg = "Invalid cmd";
         return 1;
     }
@@ -388,74 +846,227 @@ int JsonProcessor::RequestParameters::checkParams(String& errorMsg) const {
         return 1;
     }
 
+    if (ease == Easing::NumCurves) {
+        errorMsg = "Invalid ease";
+        return 1;
+    }
+
+    // eased and Oklab fades are computed by the app and bypass the animation queue
+    if (isTransition()) {
+        if (cmd == "solid" || (mode != Mode::Hsv && mode != Mode::Raw) || relative || hasHsvFrom || hasRawFrom) {
+            errorMsg = "ease and fade_oklab need a fade with absolute values";
+            return 1;
+        }
+        if (queue != QueuePolicy::Single || requeue || ramp.type != RampTimeOrSpeed::Type::Time) {
+            errorMsg = "ease and fade_oklab need queue policy single and a ramp time";
+            return 1;
+        }
+    }
+
     return 0;
 }
 
 bool JsonProcessor::onJsonRpc(const String& json) {
     debug_d("JsonProcessor::onJsonRpc: %s\n", json.c_str());
-    JsonRpcMessageIn rpc(json);
 
+    // only single color commands without "at" are cached, so a hit is always one of those.
+    // Other methods miss the lookup without counting as a cache miss.
     String msg;
+    const RequestParameters* pParams = _paramsCache.get(json);
+    if (pParams != nullptr)
+        return queueColorCommand(*pParams, msg);
+
+    JsonRpcMessageIn rpc(json);
+
     String method = rpc.getMethod();
+    JsonObject params = rpc.getParams();
+    if (method == "color" && params["cmds"].isNull() && params["at"].isNull()) {
+        RequestParameters parsed;
+        parseRequestParams(params, parsed);
+        if (parsed.checkParams(msg) != 0)
+            return false;
+
+        _paramsCache.put(json, parsed);
+        return queueColorCommand(parsed, msg);
+    }
+    return dispatch(method, params);
+}
+
+bool JsonProcessor::dispatch(const String& method, JsonObject params) {
+    String msg;
     if (method == "color") {
-        return onColor(rpc.getParams(), msg, false);
+        return onColor(params, msg, false);
     }
     else if (method == "stop") {
-        return onStop(rpc.getParams(), msg, false);
+        return onStop(params, msg, false);
     }
     else if (method == "blink") {
-        return onBlink(rpc.getParams(), msg, false);
+        return onBlink(params, msg, false);
     }
     else if (method == "skip") {
-        return onSkip(rpc.getParams(), msg, false);
+        return onSkip(params, msg, false);
     }
     else if (method == "pause") {
-        return onPause(rpc.getParams(), msg, false);
+        return onPause(params, msg, false);
     }
     else if (method == "continue") {
-        return onContinue(rpc.getParams(), msg, false);
+        return onContinue(params, msg, false);
     }
     else if (method == "direct") {
-        return onDirect(rpc.getParams(), msg, false);
+        return onDirect(params, msg, false);
     }
     else if (method == "toggle") {
-        return onToggle(rpc.getParams(), msg, false);
+        return onToggle(params, msg, false);
+    }
+    else if (method == "scene") {
+        return onScene(params, msg, false);
+    }
+    else if (method == "effect") {
+        return onEffect(params, msg, false);
+    }
+    else if (method == "sequence") {
+        return onSequence(params, msg, false);
     } else {
     	return false;
     }
 }
 
-void JsonProcessor::addChannelStatesToCmd(JsonObject root, const RGBWWLed::ChannelList& channels) {
+bool JsonProcessor::deferCommand(const String& method, JsonObject root, bool relay) {
+    // "at" is a step of the clock master, the relaying master stamps commands with its lead time
+    uint32_t at;
+    if (!Json::getValue(root["at"], at)) {
+        if (!relay || !app.cfg.sync.cmd_master_enabled || app.cfg.sync.cmd_lead_ms <= 0)
+            return false;
+
+        uint32_t masterSteps;
+        if (!app.rgbwwctrl.toMasterSteps(app.rgbwwctrl.getStepCounter(), masterSteps))
+            return false;
+        at = masterSteps + app.cfg.sync.cmd_lead_ms / RGBWW_MINTIMEDIFF;
+        root["at"] = at;
+    }
+
+    // without a master timeline, too late or too far ahead: run it right away
+    uint32_t due;
+    const bool hasTimeline = app.rgbwwctrl.toLocalSteps(at, due);
+    const int32_t ahead = static_cast<int32_t>(due - app.rgbwwctrl.getStepCounter());
+    if (!hasTimeline || ahead <= 0 || ahead > APP_SCHEDULED_HORIZON_STEPS || _scheduled.count() >= APP_SCHEDULED_MAX) {
+        debug_w("JsonProcessor::deferCommand: running %s now (at: %u, ahead: %d)", method.c_str(), at, ahead);
+        root.remove("at");
+        return false;
+    }
+
+    if (relay)
+        app.onCommandRelay(method, root);
+
+    ScheduledCommand cmd;
+    cmd.due = due;
+    cmd.method = method;
+    root.remove("at");
+    cmd.params = Json::serialize(root);
+
+    unsigned pos = _scheduled.count();
+    while (pos > 0 && static_cast<int32_t>(_scheduled[pos - 1].due - due) > 0)
+        --pos;
+    _scheduled.insertElementAt(cmd, pos);
+
+    debug_d("JsonProcessor::deferCommand: %s in %d steps", method.c_str(), ahead);
+    return true;
+}
+
+void JsonProcessor::onStep(uint32_t step) {
+    while (_scheduled.count() > 0 && static_cast<int32_t>(_scheduled[0].due - step) <= 0) {
+        const ScheduledCommand cmd = _scheduled[0];
+        _scheduled.removeElementAt(0);
+
+        StaticJsonDocument<256> doc;
+        Json::deserialize(doc, cmd.params);
+        if (!dispatch(cmd.method, doc.as<JsonObject>()))
+            debug_w("JsonProcessor::onStep: scheduled %s failed", cmd.method.c_str());
+    }
+}
+
+const RGBWWLed::ChannelList& JsonProcessor::toChannelList(ChannelMask channels) {
+    if (channels == _channelListMask)
+        return _channelList;
+
+    _channelList.clear();
+    for(const auto& entry : channelNames) {
+        if (channels & channelBit(entry.channel))
+            _channelList.add(entry.channel);
+    }
+    _channelListMask = channels;
+    return _channelList;
+}
+
+void JsonProcessor::addChannelStatesToCmd(JsonObject root, ChannelMask channels) {
     switch(app.rgbwwctrl.getMode()) {
     case RGBWWLed::ColorMode::Hsv:
     {
         const HSVCT& c = app.rgbwwctrl.getCurrentColor();
         JsonObject obj = root.createNestedObject("hsv");
-        if (channels.count() == 0 || channels.contains(CtrlChannel::Hue))
+        if (hasChannel(channels, CtrlChannel::Hue))
             obj["h"] = (float(c.h) / float(RGBWW_CALC_HUEWHEELMAX)) * 360.0;
-        if (channels.count() == 0 || channels.contains(CtrlChannel::Sat))
+        if (hasChannel(channels, CtrlChannel::Sat))
             obj["s"] = (float(c.s) / float(RGBWW_CALC_MAXVAL)) * 100.0;
-        if (channels.count() == 0 || channels.contains(CtrlChannel::Val))
+        if (hasChannel(channels, CtrlChannel::Val))
             obj["v"] = (float(c.v) / float(RGBWW_CALC_MAXVAL)) * 100.0;
-        if (channels.count() == 0 || channels.contains(CtrlChannel::ColorTemp))
+        if (hasChannel(channels, CtrlChannel::ColorTemp))
             obj["ct"] = c.ct;
         break;
     }
     case RGBWWLed::ColorMode::Raw:
     {
-        const ChannelOutput& c = app.rgbwwctrl.getCurrentOutput();
+        const ChannelOutput c = app.rgbwwctrl.getCorrectedOutput();
         JsonObject obj = root.createNestedObject("raw");
-        if (channels.count() == 0 || channels.contains(CtrlChannel::Red))
+        if (hasChannel(channels, CtrlChannel::Red))
             obj["r"] = c.r;
-        if (channels.count() == 0 || channels.contains(CtrlChannel::Green))
+        if (hasChannel(channels, CtrlChannel::Green))
             obj["g"] = c.g;
-        if (channels.count() == 0 || channels.contains(CtrlChannel::Blue))
+        if (hasChannel(channels, CtrlChannel::Blue))
             obj["b"] = c.b;
-        if (channels.count() == 0 || channels.contains(CtrlChannel::WarmWhite))
+        if (hasChannel(channels, CtrlChannel::WarmWhite))
             obj["ww"] = c.ww;
-        if (channels.count() == 0 || channels.contains(CtrlChannel::ColdWhite))
+        if (hasChannel(channels, CtrlChannel::ColdWhite))
             obj["cw"] = c.cw;
         break;
     }
     }
 }
+
+uint32_t JsonProcessor::ParamsCache::hash(const String& payload) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (unsigned i=0; i < payload.length(); ++i) {
+        h ^= static_cast<uint8_t>(payload[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+const JsonProcessor::RequestParameters* JsonProcessor::ParamsCache::get(const String& payload) {
+    const uint32_t h = hash(payload);
+    for (auto& entry : _entries) {
+        if (entry.hash == h && entry.payload == payload) {
+            entry.lastUse = ++_useCounter;
+            ++_hits;
+            return &entry.params;
+        }
+    }
+    return nullptr;
+}
+
+void JsonProcessor::ParamsCache::put(const String& payload, const RequestParameters& params) {
+    // every cacheable command that had to be parsed is a miss
+    ++_misses;
+
+    Entry* pOldest = &_entries[0];
+    for (auto& entry : _entries) {
+        if (entry.lastUse < pOldest->lastUse)
+            pOldest = &entry;
+    }
+
+    pOldest->hash = hash(payload);
+    pOldest->lastUse = ++_useCounter;
+    pOldest->payload = payload;
+    pOldest->params = params;
+}
@@ -65,12 +65,18 @@ void APPLedCtrl::init() {
     debug_i("APPLedCtrl::init");
 
     _stepSync = new StepSync();
+    _stepSync->load();
 
     const PinConfig pins = APPLedCtrl::parsePinConfigString(app.cfg.general.pin_config);
 
     RGBWWLed::init(pins.red, pins.green, pins.blue, pins.warmwhite, pins.coldwhite, PWM_FREQUENCY);
+    // the library writes through the staged output, only writeOutput() reaches the hardware
+    delete _pwm_output;
+    _stagedOutput = new StagedPWMOutput(pins.red, pins.green, pins.blue, pins.warmwhite, pins.coldwhite, PWM_FREQUENCY);
+    _pwm_output = _stagedOutput;
 
     setup();
+    _energyMeter.load();
 
     HSVCT startupColor;
     if (app.cfg.color.startup_color == "last") {
@@ -92,17 +98,45 @@ void APPLedCtrl::init() {
 void APPLedCtrl::setup() {
     debug_i("APPLedCtrl::setup");
 
-    colorutils.setBrightnessCorrection(app.cfg.color.brightness.red,
+    // brightness correction is part of the output tables, so the library passes values through
+    const int brightness[OutputLut::NumChannels] = { app.cfg.color.brightness.red,
             app.cfg.color.brightness.green, app.cfg.color.brightness.blue,
-            app.cfg.color.brightness.ww, app.cfg.color.brightness.cw);
+            app.cfg.color.brightness.ww, app.cfg.color.brightness.cw };
+    _outputLut.build(brightness, OutputLut::curveFromName(app.cfg.color.dimming.curve), app.cfg.color.dimming.gamma);
+    colorutils.setBrightnessCorrection(100, 100, 100, 100, 100);
+
+    _calibration.build(app.cfg.color.calibration.rgb, app.cfg.color.calibration.white);
+
+    const auto& dither = app.cfg.color.dithering;
+    _outputLut.setDithering((dither.red << 0) | (dither.green << 1) | (dither.blue << 2) | (dither.ww << 3) | (dither.cw << 4));
+
     colorutils.setHSVcorrection(app.cfg.color.hsv.red, app.cfg.color.hsv.yellow,
             app.cfg.color.hsv.green, app.cfg.color.hsv.cyan,
             app.cfg.color.hsv.blue, app.cfg.color.hsv.magenta);
 
-    colorutils.setColorMode((RGBWW_COLORMODE) app.cfg.color.outputmode);
+#ifdef APP_FIXED_COLORMODE
+    const int colorMode = APP_FIXED_COLORMODE;
+#else
+    const int colorMode = app.cfg.color.outputmode;
+#endif
+    colorutils.setColorMode((RGBWW_COLORMODE) colorMode);
+    _outputKernel = OutputLut::kernelFor(colorMode);
     colorutils.setHSVmodel((RGBWW_HSVMODEL) app.cfg.color.hsv.model);
 
     colorutils.setWhiteTemperature(app.cfg.color.colortemp.ww, app.cfg.color.colortemp.cw);
+
+    // the table splits the white level between both white channels, so it needs both
+    _cctTable.build(app.cfg.color.colortemp.ww, app.cfg.color.colortemp.cw, app.cfg.color.colortemp.rgb_assist);
+    _cctTable.setEnabled(app.cfg.color.colortemp.table && colorMode == RGBWWCW);
+
+    const int currentMa[PowerLimiter::NumChannels] = { app.cfg.power.red_ma, app.cfg.power.green_ma,
+            app.cfg.power.blue_ma, app.cfg.power.ww_ma, app.cfg.power.cw_ma };
+    _powerLimiter.configure(currentMa, app.cfg.power.budget_ma);
+
+    uint32_t powerMw[EnergyMeter::NumChannels];
+    for (unsigned i=0; i < EnergyMeter::NumChannels; ++i)
+        powerMw[i] = (static_cast<uint32_t>(std::max(currentMa[i], 0)) * std::max(app.cfg.power.voltage_mv, 0)) / 1000;
+    _energyMeter.configure(powerMw, RGBWW_MINTIMEDIFF);
 }
 
 void APPLedCtrl::publishToEventServer() {
@@ -113,7 +147,7 @@ void APPLedCtrl::publishToEventServer() {
     if (_mode == ColorMode::Hsv)
         pHsv = &getCurrentColor();
 
-    app.eventserver.publishCurrentState(getCurrentOutput(), pHsv);
+    app.eventserver.publishCurrentState(getCorrectedOutput(), pHsv);
 }
 
 void APPLedCtrl::publishToMqtt() {
@@ -125,7 +159,7 @@ void APPLedCtrl::publishToMqtt() {
         app.mqttclient.publishCurrentHsv(getCurrentColor());
         break;
     case ColorMode::Raw:
-        app.mqttclient.publishCurrentRaw(getCurrentOutput());
+        app.mqttclient.publishCurrentRaw(getCorrectedOutput());
         break;
     }
 }
@@ -136,17 +170,51 @@ void APPLedCtrl::updateLedCb(void* pTimerArg) {
 }
 
 void APPLedCtrl::updateLed() {
+    _stepStartUs = micros();
+
     // arm next timer
+    if (_restoreInterval) {
+        _ledTimer.setIntervalUs(_timerInterval);
+        _restoreInterval = false;
+    }
     _ledTimer.startOnce();
 
+    // scheduled commands take effect in this step
+    app.jsonproc.onStep(_stepCounter);
+
     const bool animFinished = show();
 
+    if (_transition.isActive() && !_transition.process(*this))
+        onAnimationFinished(_transitionName, false);
+
+    if (_sequence.isActive() && !_sequence.process(*this))
+        onAnimationFinished(_sequence.getName(), false);
+
+    // the library's own PWM writes are held back, the step is written once through the output stage
+    if (_effects.isActive())
+        applyEffect();
+    else
+        writeOutput((_mode == ColorMode::Hsv) ? mixColorTemp(getCurrentColor(), getCurrentOutput()) : getCurrentOutput());
+
     ++_stepCounter;
 
-    if (app.cfg.sync.clock_master_enabled) {
-        if ((_stepCounter % (app.cfg.sync.clock_master_interval * RGBWW_UPDATEFREQUENCY)) == 0) {
+    if (_powerLimiter.hasModel() && (_stepCounter % RGBWW_UPDATEFREQUENCY) == 0) {
+        publishPower();
+        updateEnergy();
+    }
+
+    if (app.clockelection.isActive() && (_stepCounter % RGBWW_UPDATEFREQUENCY) == 0)
+        app.clockelection.onTick(_stepCounter);
+
+    if (isClockMaster()) {
+        // an elected master's heartbeats are the MQTT clock
+        if (!app.clockelection.isActive() && (_stepCounter % (app.cfg.sync.clock_master_interval * RGBWW_UPDATEFREQUENCY)) == 0) {
             app.mqttclient.publishClock(_stepCounter);
         }
+
+        // slaves pick the packets with the least delay, so the UDP clock is sent more often
+        if (app.cfg.sync.clock_udp_enabled && (_stepCounter % RGBWW_UPDATEFREQUENCY) == 0)
+            app.clockudp.sendClock(_stepCounter, micros() - _stepStartUs);
     }
 
     const static uint32_t stepLenMs = 1000 / RGBWW_UPDATEFREQUENCY;
@@ -178,6 +246,115 @@ void APPLedCtrl::updateLed() {
     }
 }
 
+void APPLedCtrl::applyEffect() {
+    // the effect is an overlay, the animated color itself stays untouched
+    ChannelOutput output;
+    if (_mode == ColorMode::Hsv) {
+        HSVCT color = getCurrentColor();
+        _effects.apply(_stepCounter, color);
+        colorutils.HSVtoRGB(color, output);
+        output = mixColorTemp(color, output);
+    }
+    else {
+        output = getCurrentOutput();
+        _effects.apply(_stepCounter, output);
+    }
+    writeOutput(output);
+}
+
+ChannelOutput APPLedCtrl::getCorrectedOutput() const {
+    // the library passes values through, the brightness correction is part of the output tables
+    ChannelOutput output = getCurrentOutput();
+    _outputLut.correct(output);
+    return output;
+}
+
+ChannelOutput APPLedCtrl::mixColorTemp(const HSVCT& color, ChannelOutput output) const {
+    // overwrites the white split the library already computed for output
+    if (_cctTable.isEnabled())
+        _cctTable.apply(color.ct, output);
+    return output;
+}
+
+void APPLedCtrl::writeOutput(ChannelOutput output) {
+    if (!_calibration.isIdentity())
+        _calibration.apply(output);
+    if (!_outputLut.isIdentity())
+        _outputKernel(_outputLut, output);
+    if (_powerLimiter.hasModel()) {
+        _powerLimiter.apply(output);
+        _energyMeter.add(output);
+    }
+    _stagedOutput->write(output);
+}
+
+void APPLedCtrl::startEffect(const EffectEngine::Params& params) {
+    debug_d("APPLedCtrl::startEffect: %s", EffectEngine::toName(params.effect));
+    _effects.start(params);
+}
+
+void APPLedCtrl::stopEffect() {
+    debug_d("APPLedCtrl::stopEffect");
+    _effects.stop();
+    refresh();
+}
+
+void APPLedCtrl::prepareTransition(const String& name) {
+    // the transition drives the color directly, queued animations would fight it
+    stopSequence();
+    clearAnimationQueue(ChannelList());
+    skipAnimation(ChannelList());
+    _transitionName = name;
+}
+
+void APPLedCtrl::fadeEased(const HSVCT& to, uint32_t ms, uint8_t ease, ChannelMask channels, int direction, const String& name) {
+    debug_d("APPLedCtrl::fadeEased: HSV in %u ms", ms);
+    prepareTransition(name);
+    _transition.startHsv(getCurrentColor(), to, ms, ease, channels, direction);
+}
+
+void APPLedCtrl::fadeEased(const ChannelOutput& to, uint32_t ms, uint8_t ease, ChannelMask channels, const String& name) {
+    debug_d("APPLedCtrl::fadeEased: RAW in %u ms", ms);
+    prepareTransition(name);
+    _transition.startRaw(getCurrentOutput(), to, ms, ease, channels);
+}
+
+void APPLedCtrl::fadeOklab(const HSVCT& to, uint32_t ms, uint8_t ease, const String& name) {
+    debug_d("APPLedCtrl::fadeOklab: HSV in %u ms", ms);
+    prepareTransition(name);
+
+    HSVCT target = to;
+    ChannelOutput output;
+    colorutils.HSVtoRGB(target, output);
+    _transition.startOklab(getCurrentOutput(), output, to, ms, ease);
+}
+
+void APPLedCtrl::fadeOklab(const ChannelOutput& to, uint32_t ms, uint8_t ease, const String& name) {
+    debug_d("APPLedCtrl::fadeOklab: RAW in %u ms", ms);
+    prepareTransition(name);
+    _transition.startOklab(getCurrentOutput(), to, ms, ease);
+}
+
+void APPLedCtrl::stopTransition() {
+    _transition.stop();
+}
+
+bool APPLedCtrl::startSequence(const String& name) {
+    debug_d("APPLedCtrl::startSequence: %s", name.c_str());
+    if (!_sequence.start(name))
+        return false;
+
+    stopTransition();
+    clearAnimationQueue(ChannelList());
+    skipAnimation(ChannelList());
+    return true;
+}
+
+void APPLedCtrl::stopSequence() {
+    debug_d("APPLedCtrl::stopSequence");
+    _sequence.stop();
+}
+
 void APPLedCtrl::checkStableColorState() {
 	if (app.cfg.color.startup_color != "last")
 		return;
@@ -212,7 +389,21 @@ void APPLedCtrl::onMasterClockReset() {
 }
 
 void APPLedCtrl::onMasterClock(uint32_t stepsMaster) {
-    _timerInterval = _stepSync->onMasterClock(_stepCounter, stepsMaster);
+    steerToMaster(stepsMaster, StepSync::NoSubStep);
+}
+
+void APPLedCtrl::onMasterClock(uint32_t stepsMaster, uint32_t masterStepUs, uint32_t recvUs) {
+    // both counters name the step after the running one, so the times into the running steps compare
+    const int32_t localStepUs = static_cast<int32_t>(recvUs - _stepStartUs);
+    steerToMaster(stepsMaster, static_cast<int32_t>(masterStepUs) - localStepUs);
+}
+
+void APPLedCtrl::steerToMaster(uint32_t stepsMaster, int32_t subStepUs) {
+    // the NTP timeline replaces the clock master
+    if (app.ntptimeline.isActive())
+        return;
+
+    _timerInterval = _stepSync->onMasterClock(_stepCounter, stepsMaster, subStepUs);
 
     // limit interval to sane values (just for safety)
     _timerInterval = std::min(std::max(_timerInterval, RGBWW_MINTIMEDIFF_US / 2u), static_cast<uint32_t>(RGBWW_MINTIMEDIFF_US * 1.5));
@@ -220,10 +411,157 @@ void APPLedCtrl::onMasterClock(uint32_t stepsMaster) {
     publishStatus();
 }
 
+void APPLedCtrl::onWallClock(uint32_t steps, uint32_t usToNextStep) {
+    // wall clock steps are the running step, _stepCounter is the next one
+    const int offset = static_cast<int32_t>(steps - (_stepCounter - 1));
+    if (!_wallClockAligned || abs(offset) > APP_WALLCLOCK_MAXSTEER_STEPS) {
+        debug_i("APPLedCtrl::onWallClock: aligning step counter (offset %d)", offset);
+        _stepCounter = steps + 1;
+        _stepSync->reset();
+        _timerInterval = _stepSync->onMasterClock(steps, steps);
+
+        // the next step starts at the wall clock step boundary
+        _ledTimer.setIntervalUs(usToNextStep);
+        _ledTimer.startOnce();
+        _restoreInterval = true;
+        _wallClockAligned = true;
+        return;
+    }
+
+    _timerInterval = _stepSync->onMasterClock(_stepCounter - 1, steps);
+    _timerInterval = std::min(std::max(_timerInterval, RGBWW_MINTIMEDIFF_US / 2u), static_cast<uint32_t>(RGBWW_MINTIMEDIFF_US * 1.5));
+    _ledTimer.setIntervalUs(_timerInterval);
+    publishStatus();
+}
+
+void APPLedCtrl::onColorFrame(const ColorFrame& frame) {
+    // a late frame must not undo a newer one. Far older steps are a restarted master.
+    const int32_t age = static_cast<int32_t>(_colorFrameStep - frame.step);
+    if (_hasColorFrame && age > 0 && age < APP_COLORFRAME_MAXAGE_STEPS)
+        return;
+    _hasColorFrame = true;
+    _colorFrameStep = frame.step;
+
+    // same as a JSON "solid" color with t = 0, without the parsing
+    stopTransition();
+    stopSequence();
+    if (frame.mode == ColorFrame::Hsv) {
+        RequestHSVCT color;
+        color.h = AbsOrRelValue(frame.values[0]);
+        color.s = AbsOrRelValue(frame.values[1]);
+        color.v = AbsOrRelValue(frame.values[2]);
+        color.ct = AbsOrRelValue(frame.values[3]);
+        setHSV(color, 0, QueuePolicy::Single, false, "");
+    }
+    else {
+        RequestChannelOutput output;
+        output.r = AbsOrRelValue(frame.values[0]);
+        output.g = AbsOrRelValue(frame.values[1]);
+        output.b = AbsOrRelValue(frame.values[2]);
+        output.ww = AbsOrRelValue(frame.values[3]);
+        output.cw = AbsOrRelValue(frame.values[4]);
+        setRAW(output, 0, QueuePolicy::Single);
+    }
+}
+
+bool APPLedCtrl::toLocalSteps(uint32_t masterSteps, uint32_t& steps) const {
+    // all devices on the NTP timeline share the step counter
+    if (isClockMaster() || _wallClockAligned) {
+        steps = masterSteps;
+        return true;
+    }
+    return isClockSlave() && _stepSync->toLocalSteps(masterSteps, steps);
+}
+
+bool APPLedCtrl::toMasterSteps(uint32_t steps, uint32_t& masterSteps) const {
+    if (isClockMaster() || _wallClockAligned) {
+        masterSteps = steps;
+        return true;
+    }
+    return isClockSlave() && _stepSync->toMasterSteps(steps, masterSteps);
+}
+
+bool APPLedCtrl::isClockMaster() const {
+    if (app.cfg.sync.clock_election_enabled)
+        return app.clockelection.isMaster();
+    return app.cfg.sync.clock_master_enabled;
+}
+
+bool APPLedCtrl::isClockSlave() const {
+    if (app.cfg.sync.clock_election_enabled)
+        return app.clockelection.isActive() && !app.clockelection.isMaster();
+    return app.cfg.sync.clock_slave_enabled;
+}
+
+void APPLedCtrl::continueTimeline() {
+    // an elected master goes on with the steps of the master it followed,
+    // so the other devices keep their phase and scheduled commands their step
+    uint32_t masterSteps;
+    if (!_wallClockAligned && _stepSync->toMasterSteps(_stepCounter, masterSteps)) {
+        debug_i("APPLedCtrl::continueTimeline: step %u -> %u", _stepCounter, masterSteps);
+        _stepCounter = masterSteps;
+    }
+
+    // keep the frequency of the old master, without the phase correction
+    _timerInterval = _stepSync->reset();
+    _ledTimer.setIntervalUs(_timerInterval);
+    publishStatus();
+}
+
 void APPLedCtrl::publishStatus() {
-    app.eventserver.publishClockSlaveStatus(_stepSync->getCatchupOffset(), _timerInterval);
+    app.eventserver.publishClockSlaveStatus(_stepSync->getCatchupOffset(), _timerInterval,
+            _stepSync->getDrift(), _stepSync->isLocked());
     app.mqttclient.publishClockSlaveOffset(_stepSync->getCatchupOffset());
     app.mqttclient.publishClockInterval(_timerInterval);
+    app.mqttclient.publishClockSlaveStatus(_stepSync->getCatchupOffset(), _stepSync->getDrift(), _stepSync->isLocked());
+}
+
+uint32_t APPLedCtrl::getPowerMw() const {
+    return (static_cast<uint64_t>(_powerLimiter.getCurrent()) * app.cfg.power.voltage_mv) / 1000;
+}
+
+void APPLedCtrl::publishPower() {
+    // once per second at most and only on changes
+    const uint32_t current = _powerLimiter.getCurrent();
+    if (current == _lastPublishedCurrent)
+        return;
+    _lastPublishedCurrent = current;
+
+    app.eventserver.publishPowerStatus(current, getPowerMw(), _powerLimiter.isLimited());
+    app.mqttclient.publishPowerStatus(current, getPowerMw(), _powerLimiter.isLimited());
+}
+
+void APPLedCtrl::updateEnergy() {
+    // called once per second
+    ++_energySeconds;
+    _energyDirty |= _energyMeter.update();
+
+    const uint32_t publishInterval = std::max(app.cfg.energy.publish_interval_s, 1);
+    if ((_energySeconds % publishInterval) == 0)
+        app.mqttclient.publishEnergy(_energyMeter);
+
+    if (_energyDirty && (_energySeconds - _energySavedAt) >= std::max(app.cfg.energy.save_interval_min, 1) * 60u)
+        saveEnergy();
+}
+
+void APPLedCtrl::saveEnergy() {
+    if (!_energyMeter.isEnabled() || !_energyDirty)
+        return;
+
+    _energyMeter.save();
+    _energySavedAt = _energySeconds;
+    _energyDirty = false;
+}
+
+void APPLedCtrl::saveClockDrift() {
+    if (_stepSync != nullptr)
+        _stepSync->flush();
+}
+
+void APPLedCtrl::resetEnergy() {
+    debug_i("APPLedCtrl::resetEnergy");
+    _energyMeter.reset();
+    _energyDirty = false;
 }
 
 void APPLedCtrl::start() {
@@ -263,6 +601,11 @@ void APPLedCtrl::onAnimationFinished(const String& name, bool requeued) {
 
 void APPLedCtrl::toggle() {
     static const int toggleFadeTime = 1000;
+
+    // the toggle fade replaces eased transitions and sequences, they would override it on the next step
+    stopTransition();
+    stopSequence();
+
     switch (_mode) {
     case ColorMode::Hsv: {
         HSVCT current = getCurrentColor();
@@ -297,3 +640,55 @@ void APPLedCtrl::toggle() {
     }
     }
 }
+
+bool APPLedCtrl::recallScene(uint8_t id) {
+    Scene scene;
+    if (!sceneStorage.load(id, scene)) {
+        debug_w("APPLedCtrl::recallScene - scene %d not found", id);
+        return false;
+    }
+
+    debug_d("APPLedCtrl::recallScene - %d", id);
+
+    // the scene replaces eased transitions and sequences, they would override it on the next step
+    stopTransition();
+    stopSequence();
+
+    // first step replaces whatever is running, the following ones are appended
+    const String name(scene.name, strnlen(scene.name, sizeof(scene.name)));
+    bool queueOk = true;
+    for (unsigned i=0; i < scene.numSteps && queueOk; ++i) {
+        const SceneStep& step = scene.steps[i];
+        const QueuePolicy queue = (i == 0) ? QueuePolicy::Single : QueuePolicy::Back;
+        const String& stepName = (i + 1 == scene.numSteps) ? name : String::empty;
+        const int ramp = static_cast<int>(step.ramp);
+
+        if (step.mode == SceneStep::Hsv) {
+            RequestHSVCT color;
+            if (step.mask & 0x01) color.h = AbsOrRelValue(step.values[0]);
+            if (step.mask & 0x02) color.s = AbsOrRelValue(step.values[1]);
+            if (step.mask & 0x04) color.v = AbsOrRelValue(step.values[2]);
+            if (step.mask & 0x08) color.ct = AbsOrRelValue(step.values[3]);
+
+            if (step.fade)
+                queueOk = fadeHSV(color, ramp, step.direction, queue, false, stepName);
+            else
+                queueOk = setHSV(color, ramp, queue, false, stepName);
+        }
+        else {
+            RequestChannelOutput output;
+            if (step.mask & 0x01) output.r = AbsOrRelValue(step.values[0]);
+            if (step.mask & 0x02) output.g = AbsOrRelValue(step.values[1]);
+            if (step.mask & 0x04) output.b = AbsOrRelValue(step.values[2]);
+            if (step.mask & 0x08) output.ww = AbsOrRelValue(step.values[3]);
+            if (step.mask & 0x10) output.cw = AbsOrRelValue(step.values[4]);
+
+            if (step.fade)
+                queueOk = fadeRAW(output, ramp, queue);
+            else
+                queueOk = setRAW(output, ramp, queue);
+        }
+    }
+
+    return queueOk;
+}
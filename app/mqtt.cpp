@@ -35,8 +35,18 @@ void AppMqttClient::onComplete(TcpClient& client, bool success) {
     else
         debug_e("MQTT Broker Unreachable!!");
 
-    // Restart connection attempt after few seconds
-    connectDelayed(2000);
+    // back off while the broker stays away. The jitter of +-25% keeps a house full
+    // of controllers from reconnecting in lockstep after a broker restart.
+    const uint32_t jitter = os_random() % (_reconnectDelayMs / 2 + 1);
+    connectDelayed(_reconnectDelayMs - _reconnectDelayMs / 4 + jitter);
+    _reconnectDelayMs = std::min(_reconnectDelayMs * 2, static_cast<uint32_t>(APP_MQTT_RECONNECT_MAX_MS));
+}
+
+int AppMqttClient::onConnected(MqttClient& client, mqtt_message_t* message) {
+    debug_i("MQTT Broker Connected");
+    _reconnectDelayMs = APP_MQTT_RECONNECT_MIN_MS;
+    flushQueue();
+    return 0;
 }
 
 void AppMqttClient::connectDelayed(int delay) {
@@ -68,19 +78,82 @@ void AppMqttClient::connect() {
 #endif
     // Assign a disconnect callback function
     mqtt->setCompleteDelegate(TcpClientCompleteDelegate(&AppMqttClient::onComplete, this));
+    mqtt->setConnectedHandler(MqttDelegate(&AppMqttClient::onConnected, this));
 
+    _routes.clear();
     if (app.cfg.sync.clock_slave_enabled) {
-        mqtt->subscribe(app.cfg.sync.clock_slave_topic);
+        addRoute(app.cfg.sync.clock_slave_topic, &AppMqttClient::onClockMessage);
+    }
+    if (app.cfg.sync.clock_election_enabled) {
+        addRoute(app.cfg.sync.clock_election_topic, &AppMqttClient::onElectionMessage);
     }
     if (app.cfg.sync.cmd_slave_enabled) {
-        mqtt->subscribe(app.cfg.sync.cmd_slave_topic);
+        addRoute(app.cfg.sync.cmd_slave_topic, &AppMqttClient::onCommandMessage);
     }
+    addGroupRoutes();
     if (app.cfg.sync.color_slave_enabled) {
-        debug_d("Subscribe: %s\n", app.cfg.sync.color_slave_topic.c_str());
-        mqtt->subscribe(app.cfg.sync.color_slave_topic);
+        addRoute(app.cfg.sync.color_slave_topic, &AppMqttClient::onColorMessage);
+    }
+}
+
+// one publish addresses every device of a group, the broker does the fan-out
+void AppMqttClient::addGroupRoutes() {
+    const String& base = app.cfg.network.mqtt.topic_base;
+    if (app.cfg.sync.cmd_broadcast_enabled) {
+        addRoute(base + "broadcast/command", &AppMqttClient::onCommandMessage);
+    }
+
+    const String& groups = app.cfg.sync.cmd_groups;
+    unsigned joined = 0;
+    int start = 0;
+    while (start < (int)groups.length()) {
+        int end = groups.indexOf(',', start);
+        if (end < 0)
+            end = groups.length();
+
+        String name = groups.substring(start, end);
+        name.trim();
+        start = end + 1;
+
+        // wildcards or levels in a name would subscribe to other devices' topics
+        if (name.length() == 0 || name.indexOf('/') >= 0 || name.indexOf('+') >= 0 || name.indexOf('#') >= 0) {
+            debug_w("AppMqttClient: ignoring group name '%s'\n", name.c_str());
+            continue;
+        }
+        if (joined == APP_MQTT_GROUPS_MAX) {
+            debug_w("AppMqttClient: more than %d groups, ignoring '%s'\n", APP_MQTT_GROUPS_MAX, name.c_str());
+            continue;
+        }
+
+        addRoute(base + "group/" + name + "/command", &AppMqttClient::onCommandMessage);
+        ++joined;
     }
 }
 
+// FNV-1a
+uint32_t AppMqttClient::hashTopic(const char* topic, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i=0; i < length; ++i) {
+        hash ^= static_cast<uint8_t>(topic[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void AppMqttClient::addRoute(const String& topic, RouteHandler handler) {
+    for (unsigned i=0; i < _routes.count(); ++i) {
+        if (_routes[i].topic == topic) {
+            debug_w("AppMqttClient::addRoute: %s is already routed\n", topic.c_str());
+            return;
+        }
+    }
+
+    debug_d("Subscribe: %s\n", topic.c_str());
+    Route route = { hashTopic(topic.c_str(), topic.length()), topic, handler };
+    _routes.add(route);
+    mqtt->subscribe(topic);
+}
+
 void AppMqttClient::init() {
     if (app.cfg.general.device_name.length() > 0) {
         debug_w("AppMqttClient::init: building MQTT ID from device name: '%s'\n", app.cfg.general.device_name.c_str());
@@ -90,6 +163,13 @@ void AppMqttClient::init() {
         debug_w("AppMqttClient::init: building MQTT ID from MAC (device name is: '%s')\n", app.cfg.general.device_name.c_str());
         _id = String("rgbww_") + WifiStation.getMAC();
     }
+
+    // so messages queued before the first connect have their topic
+    _topicColor = buildTopic("color");
+    _topicClock = buildTopic("clock");
+    _topicClockInterval = buildTopic("clock_interval");
+    _topicClockSlaveOffset = buildTopic("clock_slave_offset");
+    _payloadString.reserve(MqttPayload::Capacity);
 }
 
 void AppMqttClient::start() {
@@ -97,39 +177,72 @@ void AppMqttClient::start() {
 
     delete mqtt;
     mqtt = new MqttClient();
-    mqtt->setCallback(MqttStringSubscriptionCallback(&AppMqttClient::onMessageReceived, this));
+    mqtt->setMessageHandler(MqttDelegate(&AppMqttClient::onMessageReceived, this));
+    _reconnectDelayMs = APP_MQTT_RECONNECT_MIN_MS;
     connectDelayed(2000);
 }
 
 void AppMqttClient::stop() {
     delete mqtt;
     mqtt = nullptr;
+    _queue.clear();
+    _queueBytes = 0;
 }
 
 bool AppMqttClient::isRunning() const {
     return (mqtt != nullptr);
 }
 
-void AppMqttClient::onMessageReceived(String topic, String message) {
-    if (app.cfg.sync.clock_slave_enabled && (topic == app.cfg.sync.clock_slave_topic)) {
-        if (message == "reset") {
-            app.rgbwwctrl.onMasterClockReset();
-        }
-        else  {
-            uint32_t clock = message.toInt();
-            app.rgbwwctrl.onMasterClock(clock);
+int AppMqttClient::onMessageReceived(MqttClient& client, mqtt_message_t* message) {
+    const char* topic = reinterpret_cast<const char*>(message->publish.topic_name.data);
+    const size_t topicLength = message->publish.topic_name.length;
+    const uint32_t hash = hashTopic(topic, topicLength);
+
+    for (unsigned i=0; i < _routes.count(); ++i) {
+        const Route& route = _routes[i];
+        if (route.hash == hash && route.topic.length() == topicLength && memcmp(route.topic.c_str(), topic, topicLength) == 0) {
+            (this->*route.handler)(reinterpret_cast<const char*>(message->publish.content.data), message->publish.content.length);
+            break;
         }
     }
-    else if (app.cfg.sync.cmd_slave_enabled && topic == app.cfg.sync.cmd_slave_topic) {
-        app.jsonproc.onJsonRpc(message);
+    return 0;
+}
+
+void AppMqttClient::onClockMessage(const char* payload, size_t length) {
+    if (length == 5 && memcmp(payload, "reset", 5) == 0) {
+        app.rgbwwctrl.onMasterClockReset();
+        return;
     }
-    else if (app.cfg.sync.color_slave_enabled && (topic == app.cfg.sync.color_slave_topic)) {
-        String error;
-        app.jsonproc.onColor(message, error, false);
+    if (app.clockudp.isReceiving())
+        return;
+
+    // decimal step counter, the payload is not terminated
+    uint32_t clock = 0;
+    for (size_t i=0; i < length && isdigit(payload[i]); ++i)
+        clock = clock * 10 + (payload[i] - '0');
+    app.rgbwwctrl.onMasterClock(clock);
+}
+
+void AppMqttClient::onElectionMessage(const char* payload, size_t length) {
+    app.clockelection.onMessage(String(payload, length));
+}
+
+void AppMqttClient::onCommandMessage(const char* payload, size_t length) {
+    app.jsonproc.onJsonRpc(String(payload, length));
+}
+
+void AppMqttClient::onColorMessage(const char* payload, size_t length) {
+    ColorFrame frame;
+    if (frame.decode(reinterpret_cast<const uint8_t*>(payload), length)) {
+        app.rgbwwctrl.onColorFrame(frame);
+        return;
     }
+
+    String error;
+    app.jsonproc.onColor(String(payload, length), error, false);
 }
 
-void AppMqttClient::publish(const String& topic, const String& data, bool retain) {
+void AppMqttClient::publish(const String& topic, const String& data, bool retain, QueuePolicy policy) {
     //Serial.printf("AppMqttClient::publish: Topic: %s | Data: %s\n", topic.c_str(), data.c_str());
 
     if (!mqtt) {
@@ -143,9 +256,66 @@ void AppMqttClient::publish(const String& topic, const String& data, bool retain
     }
     else {
         debug_w("ApplicationMQTTClient::publish: not connected.\n");
+        enqueue(topic, data, retain, policy);
     }
 }
 
+void AppMqttClient::publish(const String& topic, const MqttPayload& payload, bool retain, QueuePolicy policy) {
+    // reserved at init, assigning does not allocate
+    _payloadString.setString(payload.c_str(), payload.length());
+    publish(topic, _payloadString, retain, policy);
+}
+
+void AppMqttClient::enqueue(const String& topic, const String& data, bool retain, QueuePolicy policy) {
+    if (policy == QueuePolicy::Drop)
+        return;
+
+    if (policy == QueuePolicy::Latest) {
+        for (unsigned i=0; i < _queue.count(); ++i) {
+            QueuedMessage& queued = _queue[i];
+            if (queued.policy == QueuePolicy::Latest && queued.topic == topic) {
+                _queueBytes = _queueBytes - queued.data.length() + data.length();
+                queued.data = data;
+                queued.retain = retain;
+                return;
+            }
+        }
+    }
+
+    const size_t size = topic.length() + data.length();
+    if (size > APP_MQTT_QUEUE_BYTES)
+        return;
+
+    // make room, oldest first
+    while (_queue.count() > 0 && (_queue.count() >= APP_MQTT_QUEUE_MAX || _queueBytes + size > APP_MQTT_QUEUE_BYTES)) {
+        debug_w("AppMqttClient: queue full, dropping %s\n", _queue[0].topic.c_str());
+        dropQueued(0);
+    }
+
+    QueuedMessage msg = { topic, data, retain, policy, millis() };
+    _queue.add(msg);
+    _queueBytes += size;
+}
+
+void AppMqttClient::dropQueued(unsigned index) {
+    _queueBytes -= _queue[index].topic.length() + _queue[index].data.length();
+    _queue.removeElementAt(index);
+}
+
+void AppMqttClient::flushQueue() {
+    debug_i("AppMqttClient: sending %d queued messages\n", _queue.count());
+
+    const uint32_t now = millis();
+    for (unsigned i=0; i < _queue.count(); ++i) {
+        const QueuedMessage& msg = _queue[i];
+        if (msg.policy == QueuePolicy::Fifo && (now - msg.queuedMs) > APP_MQTT_QUEUE_MAX_AGE_MS)
+            continue;
+        mqtt->publish(msg.topic, msg.data, msg.retain);
+    }
+    _queue.clear();
+    _queueBytes = 0;
+}
+
 void AppMqttClient::publishCurrentRaw(const ChannelOutput& raw) {
     if (raw == _lastRaw)
         return;
@@ -153,20 +323,20 @@ void AppMqttClient::publishCurrentRaw(const ChannelOutput& raw) {
 
     debug_d("ApplicationMQTTClient::publishCurrentRaw\n");
 
-    StaticJsonDocument<200> doc;
-    JsonObject root = doc.to<JsonObject>();
-    JsonObject rawJson = root.createNestedObject("raw");
-    rawJson["r"] = raw.r;
-    rawJson["g"] = raw.g;
-    rawJson["b"] = raw.b;
-    rawJson["cw"] = raw.cw;
-    rawJson["ww"] = raw.ww;
-
-    root["t"] = 0;
-    root["cmd"] = "solid";
+    if (app.cfg.sync.color_master_binary) {
+        ColorFrame frame;
+        frame.mode = ColorFrame::Raw;
+        frame.values[0] = raw.r;
+        frame.values[1] = raw.g;
+        frame.values[2] = raw.b;
+        frame.values[3] = raw.ww;
+        frame.values[4] = raw.cw;
+        publishColorFrame(frame);
+        return;
+    }
 
-    String jsonMsg = Json::serialize(root);
-    publish(buildTopic("color"), jsonMsg, true);
+    _payload.setRaw(raw.r, raw.g, raw.b, raw.cw, raw.ww);
+    publish(_topicColor, _payload, true, QueuePolicy::Latest);
 }
 
 void AppMqttClient::publishCurrentHsv(const HSVCT& color) {
@@ -176,23 +346,35 @@ void AppMqttClient::publishCurrentHsv(const HSVCT& color) {
 
     debug_d("ApplicationMQTTClient::publishCurrentHsv\n");
 
+    if (app.cfg.sync.color_master_binary) {
+        ColorFrame frame;
+        frame.mode = ColorFrame::Hsv;
+        frame.values[0] = color.h;
+        frame.values[1] = color.s;
+        frame.values[2] = color.v;
+        frame.values[3] = color.ct;
+        publishColorFrame(frame);
+        return;
+    }
+
     float h, s, v;
     int ct;
     color.asRadian(h, s, v, ct);
 
-    StaticJsonDocument<200> doc;
-    JsonObject root = doc.to<JsonObject>();
-    JsonObject hsv = root.createNestedObject("hsv");
-    hsv["h"] = h;
-    hsv["s"] = s;
-    hsv["v"] = v;
-    hsv["ct"] = ct;
+    _payload.setHsv(h, s, v, ct);
+    publish(_topicColor, _payload, true, QueuePolicy::Latest);
+}
 
-    root["t"] = 0;
-    root["cmd"] = "solid";
+void AppMqttClient::publishColorFrame(ColorFrame& frame) {
+    // the master step lets slaves skip frames older than the one applied
+    const uint32_t steps = app.rgbwwctrl.getStepCounter();
+    if (!app.rgbwwctrl.toMasterSteps(steps, frame.step))
+        frame.step = steps;
 
-    String jsonMsg = Json::serialize(root);
-    publish(buildTopic("color"), jsonMsg, true);
+    uint8_t buffer[ColorFrame::Size];
+    frame.encode(buffer);
+    _payloadString.setString(reinterpret_cast<const char*>(buffer), sizeof(buffer));
+    publish(_topicColor, _payloadString, true, QueuePolicy::Latest);
 }
 
 String AppMqttClient::buildTopic(const String& suffix) {
@@ -207,29 +389,69 @@ void AppMqttClient::publishClock(uint32_t steps) {
         _firstClock = false;
     }
     else {
-        String msg;
-        msg += steps;
-
-        publish(buildTopic("clock"), msg, false);
+        _payload.setUint(steps);
+        publish(_topicClock, _payload, false);
     }
 }
 
 void AppMqttClient::publishClockReset() {
-    publish(buildTopic("clock"), "reset", false);
+    publish(_topicClock, "reset", false);
 }
 
 void AppMqttClient::publishClockInterval(uint32_t curInterval) {
-    String msg;
-    msg += curInterval;
-
-    publish(buildTopic("clock_interval"), msg, false);
+    _payload.setUint(curInterval);
+    publish(_topicClockInterval, _payload, false);
 }
 
 void AppMqttClient::publishClockSlaveOffset(int offset) {
-    String msg;
-    msg += offset;
+    _payload.setInt(offset);
+    publish(_topicClockSlaveOffset, _payload, false);
+}
+
+void AppMqttClient::publishPowerStatus(uint32_t currentMa, uint32_t powerMw, bool limited) {
+    StaticJsonDocument<128> doc;
+    JsonObject root = doc.to<JsonObject>();
+    root["current_ma"] = currentMa;
+    root["power_mw"] = powerMw;
+    root["limited"] = limited;
+
+    String jsonMsg = Json::serialize(root);
+    publish(buildTopic("power"), jsonMsg, false, QueuePolicy::Latest);
+}
+
+void AppMqttClient::publishEnergy(const EnergyMeter& meter) {
+    StaticJsonDocument<192> doc;
+    JsonObject root = doc.to<JsonObject>();
+    root["total_mwh"] = meter.getTotalEnergy();
+    JsonArray channels = root.createNestedArray("mwh");
+    for (unsigned i=0; i < EnergyMeter::NumChannels; ++i)
+        channels.add(meter.getEnergy(i));
 
-    publish(buildTopic("clock_slave_offset"), msg, false);
+    String jsonMsg = Json::serialize(root);
+    publish(buildTopic("energy"), jsonMsg, true, QueuePolicy::Latest);
+}
+
+void AppMqttClient::publishClockSlaveStatus(int offset, int driftPpm, bool locked) {
+    StaticJsonDocument<128> doc;
+    JsonObject root = doc.to<JsonObject>();
+    root["offset"] = offset;
+    root["drift_ppm"] = driftPpm;
+    root["locked"] = locked;
+
+    String jsonMsg = Json::serialize(root);
+    publish(buildTopic("clock_slave_status"), jsonMsg, false);
+}
+
+void AppMqttClient::publishElection(const char* role, uint32_t steps) {
+    StaticJsonDocument<128> doc;
+    JsonObject root = doc.to<JsonObject>();
+    root["id"] = _id;
+    root["role"] = role;
+    if (steps > 0)
+        root["steps"] = steps;
+
+    String jsonMsg = Json::serialize(root);
+    publish(app.cfg.sync.clock_election_topic, jsonMsg, false);
 }
 
 void AppMqttClient::publishCommand(const String& method, const JsonObject& params) {
@@ -241,7 +463,7 @@ void AppMqttClient::publishCommand(const String& method, const JsonObject& param
         msg.getRoot()["params"] = params;
 
     String msgStr = Json::serialize(msg.getRoot());
-    publish(buildTopic("command"), msgStr, false);
+    publish(buildTopic("command"), msgStr, false, QueuePolicy::Fifo);
 }
 
 void AppMqttClient::publishTransitionFinished(const String& name, bool requeued) {
@@ -253,5 +475,5 @@ void AppMqttClient::publishTransitionFinished(const String& name, bool requeued)
     root["requequed"] = requeued;
 
     String jsonMsg = Json::serialize(root);
-    publish(buildTopic("transition_finished"), jsonMsg, true);
+    publish(buildTopic("transition_finished"), jsonMsg, true, QueuePolicy::Fifo);
 }
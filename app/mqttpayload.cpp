@@ -0,0 +1,100 @@
+#include <RGBWWCtrl.h>
+
+void MqttPayload::clear() {
+    _length = 0;
+    _overflow = false;
+    _buffer[0] = '\0';
+}
+
+void MqttPayload::append(const char* text, size_t length) {
+    if (_length + length > Capacity) {
+        length = Capacity - _length;
+        _overflow = true;
+    }
+    memcpy(_buffer + _length, text, length);
+    _length += length;
+    _buffer[_length] = '\0';
+}
+
+MqttPayload& MqttPayload::add(const char* text) {
+    append(text, strlen(text));
+    return *this;
+}
+
+MqttPayload& MqttPayload::add(uint32_t value) {
+    char digits[10];
+    size_t count = 0;
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+
+    char text[10];
+    for (size_t i=0; i < count; ++i)
+        text[i] = digits[count - 1 - i];
+    append(text, count);
+    return *this;
+}
+
+MqttPayload& MqttPayload::add(int value) {
+    if (value < 0) {
+        append("-", 1);
+        return add(static_cast<uint32_t>(-static_cast<int64_t>(value)));
+    }
+    return add(static_cast<uint32_t>(value));
+}
+
+MqttPayload& MqttPayload::add(float value, unsigned decimals) {
+    decimals = std::min(decimals, 6u);
+    uint32_t scale = 1;
+    for (unsigned i=0; i < decimals; ++i)
+        scale *= 10;
+
+    if (value < 0) {
+        append("-", 1);
+        value = -value;
+    }
+    const uint64_t fixed = static_cast<uint64_t>(value * scale + 0.5f);
+    add(static_cast<uint32_t>(fixed / scale));
+    if (decimals == 0)
+        return *this;
+
+    char text[7];
+    uint32_t fraction = fixed % scale;
+    for (unsigned i=decimals; i > 0; --i) {
+        text[i - 1] = '0' + fraction % 10;
+        fraction /= 10;
+    }
+    append(".", 1);
+    append(text, decimals);
+    return *this;
+}
+
+void MqttPayload::setHsv(float h, float s, float v, int ct) {
+    clear();
+    add("{\"hsv\":{\"h\":").add(h, 5);
+    add(",\"s\":").add(s, 5);
+    add(",\"v\":").add(v, 5);
+    add(",\"ct\":").add(ct);
+    add("},\"t\":0,\"cmd\":\"solid\"}");
+}
+
+void MqttPayload::setRaw(int r, int g, int b, int cw, int ww) {
+    clear();
+    add("{\"raw\":{\"r\":").add(r);
+    add(",\"g\":").add(g);
+    add(",\"b\":").add(b);
+    add(",\"cw\":").add(cw);
+    add(",\"ww\":").add(ww);
+    add("},\"t\":0,\"cmd\":\"solid\"}");
+}
+
+void MqttPayload::setUint(uint32_t value) {
+    clear();
+    add(value);
+}
+
+void MqttPayload::setInt(int value) {
+    clear();
+    add(value);
+}
@@ -186,6 +186,20 @@ void AppWIFI::_STAGotIP(IpAddress ip, IpAddress mask, IpAddress gateway) {
     if(app.cfg.network.mqtt.enabled) {
         app.mqttclient.start();
     }
+
+    if(app.cfg.network.mqtt.enabled && app.cfg.sync.clock_election_enabled) {
+        app.clockelection.start(app.mqttclient.getId());
+    }
+
+    if(app.cfg.sync.clock_udp_enabled && (app.cfg.sync.clock_master_enabled || app.cfg.sync.clock_slave_enabled ||
+            app.cfg.sync.clock_election_enabled)) {
+        app.clockudp.start();
+    }
+
+    if(app.cfg.ntp.enabled && app.cfg.ntp.step_sync) {
+        String server = app.cfg.ntp.server.length() > 0 ? app.cfg.ntp.server : NTP_DEFAULT_SERVER;
+        app.ntptimeline.start(server, std::max(app.cfg.ntp.step_interval, 10));
+    }
 }
 
 void AppWIFI::stopAp(int delay) {
@@ -0,0 +1,96 @@
+#include <RGBWWCtrl.h>
+#include <lwip/dns.h>
+
+namespace {
+    // seconds from 1900 (NTP) to 1970 (unix)
+    const uint32_t ntpUnixOffset = 2208988800UL;
+
+    inline uint32_t readU32(const uint8_t* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    }
+
+    // NTP timestamp to unix time in us
+    uint64_t readTimestamp(const uint8_t* p) {
+        const uint64_t seconds = readU32(p) - ntpUnixOffset;
+        const uint64_t fraction = readU32(p + 4);
+        return seconds * 1000000 + ((fraction * 1000000) >> 32);
+    }
+}
+
+NtpTimeline::~NtpTimeline() {
+    stop();
+}
+
+void NtpTimeline::start(const String& server, unsigned intervalS) {
+    if (_udp != nullptr)
+        return;
+
+    debug_i("NtpTimeline::start: %s every %u s", server.c_str(), intervalS);
+    _server = server;
+    _bestRoundTripUs = _maxRoundTripUs;
+    _udp = new UdpConnection(UdpConnectionDataDelegate(&NtpTimeline::onReceive, this));
+    _udp->listen(0);
+
+    _timer.initializeMs(intervalS * 1000, TimerDelegate(&NtpTimeline::query, this)).start();
+    query();
+}
+
+void NtpTimeline::stop() {
+    _timer.stop();
+    delete _udp;
+    _udp = nullptr;
+    _waiting = false;
+}
+
+void NtpTimeline::query() {
+    ip_addr_t addr;
+    const err_t result = dns_gethostbyname(_server.c_str(), &addr, &NtpTimeline::onDnsFound, this);
+    if (result == ERR_OK)
+        send(addr);
+    else if (result != ERR_INPROGRESS)
+        debug_w("NtpTimeline: cannot resolve %s", _server.c_str());
+}
+
+void NtpTimeline::onDnsFound(const char* name, LWIP_IP_ADDR_T* ip, void* arg) {
+    NtpTimeline* self = static_cast<NtpTimeline*>(arg);
+    if (ip != nullptr && self->_udp != nullptr)
+        self->send(*ip);
+}
+
+void NtpTimeline::send(IpAddress server) {
+    if (_udp == nullptr)
+        return;
+
+    uint8_t packet[_packetSize] = {};
+    packet[0] = 0x23; // no leap indicator, version 4, client
+    _sentUs = micros();
+    _waiting = true;
+    _udp->sendTo(server, APP_NTP_PORT, reinterpret_cast<const char*>(packet), sizeof(packet));
+}
+
+void NtpTimeline::onReceive(UdpConnection& connection, char* data, int size, IpAddress remoteIP, uint16_t remotePort) {
+    const uint32_t recvUs = micros();
+    const uint8_t* packet = reinterpret_cast<const uint8_t*>(data);
+    // server mode, stratum set
+    if (!_waiting || size < _packetSize || (packet[0] & 0x07) != 4 || packet[1] == 0)
+        return;
+    _waiting = false;
+
+    const uint64_t serverRecvUs = readTimestamp(packet + 32);
+    const uint64_t serverSendUs = readTimestamp(packet + 40);
+    const uint32_t roundTripUs = (recvUs - _sentUs) - static_cast<uint32_t>(serverSendUs - serverRecvUs);
+
+    // only replies close to the best round trip recently seen, the best one slowly ages
+    _bestRoundTripUs = std::min(_bestRoundTripUs + _bestRoundTripUs / 8, _maxRoundTripUs);
+    if (roundTripUs > _bestRoundTripUs + 5000) {
+        debug_d("NtpTimeline: dropping reply with %u us round trip", roundTripUs);
+        return;
+    }
+    _bestRoundTripUs = std::min(_bestRoundTripUs, roundTripUs);
+
+    // the reply took about half of the round trip, plus our time since receiving it
+    const uint64_t nowUs = serverSendUs + roundTripUs / 2 + (micros() - recvUs);
+    const uint32_t steps = nowUs / RGBWW_MINTIMEDIFF_US;
+    const uint32_t usToNextStep = RGBWW_MINTIMEDIFF_US - (nowUs % RGBWW_MINTIMEDIFF_US);
+    app.rgbwwctrl.onWallClock(steps, usToNextStep);
+}
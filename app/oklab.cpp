@@ -0,0 +1,62 @@
+#include <RGBWWCtrl.h>
+
+#include <math.h>
+
+namespace {
+    constexpr int32_t q15(double v) {
+        return static_cast<int32_t>(v * 32768.0 + (v < 0 ? -0.5 : 0.5));
+    }
+
+    // Oklab to LMS' and linear LMS to linear sRGB, evaluated by the compiler
+    constexpr int32_t labToLms[3][3] = {
+        { q15(1.0), q15(0.3963377774), q15(0.2158037573) },
+        { q15(1.0), q15(-0.1055613458), q15(-0.0638541728) },
+        { q15(1.0), q15(-0.0894841775), q15(-1.2914855480) },
+    };
+
+    constexpr int32_t lmsToRgb[3][3] = {
+        { q15(4.0767416621), q15(-3.3077115913), q15(0.2309699292) },
+        { q15(-1.2684380046), q15(2.6097574011), q15(-0.3413193965) },
+        { q15(-0.0041960863), q15(-0.7034186147), q15(1.7076147010) },
+    };
+
+    inline int32_t mul3(const int32_t row[3], int32_t x, int32_t y, int32_t z) {
+        return static_cast<int32_t>((static_cast<int64_t>(row[0]) * x + static_cast<int64_t>(row[1]) * y + static_cast<int64_t>(row[2]) * z) >> 15);
+    }
+
+    inline int32_t cube(int32_t x) {
+        return static_cast<int32_t>((static_cast<int64_t>(x) * x * x) >> 30);
+    }
+
+    inline int toChannel(int32_t v) {
+        return constrain((v * RGBWW_CALC_MAXVAL + 16384) >> 15, 0, RGBWW_CALC_MAXVAL);
+    }
+}
+
+namespace Oklab {
+    Lab fromRgb(int r, int g, int b) {
+        const float rf = float(r) / RGBWW_CALC_MAXVAL;
+        const float gf = float(g) / RGBWW_CALC_MAXVAL;
+        const float bf = float(b) / RGBWW_CALC_MAXVAL;
+
+        const float l = cbrtf(0.4122214708f * rf + 0.5363325363f * gf + 0.0514459929f * bf);
+        const float m = cbrtf(0.2119034982f * rf + 0.6806995451f * gf + 0.1073969566f * bf);
+        const float s = cbrtf(0.0883024619f * rf + 0.2817188376f * gf + 0.6299787005f * bf);
+
+        Lab lab;
+        lab.L = lroundf((0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s) * 32768.0f);
+        lab.a = lroundf((1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s) * 32768.0f);
+        lab.b = lroundf((0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s) * 32768.0f);
+        return lab;
+    }
+
+    void toRgb(const Lab& lab, int& r, int& g, int& b) {
+        const int32_t l = cube(mul3(labToLms[0], lab.L, lab.a, lab.b));
+        const int32_t m = cube(mul3(labToLms[1], lab.L, lab.a, lab.b));
+        const int32_t s = cube(mul3(labToLms[2], lab.L, lab.a, lab.b));
+
+        r = toChannel(mul3(lmsToRgb[0], l, m, s));
+        g = toChannel(mul3(lmsToRgb[1], l, m, s));
+        b = toChannel(mul3(lmsToRgb[2], l, m, s));
+    }
+}
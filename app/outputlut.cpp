@@ -0,0 +1,82 @@
+#include <RGBWWCtrl.h>
+
+#include <math.h>
+
+namespace {
+    // relative luminance for a lightness of 0..1
+    float cie1931(float lightness) {
+        const float l = lightness * 100.0f;
+        if (l <= 8.0f)
+            return l / 903.3f;
+
+        const float y = (l + 16.0f) / 116.0f;
+        return y * y * y;
+    }
+}
+
+void OutputLut::build(const int brightness[NumChannels], Curve curve, int gamma) {
+    // Q16 table position per input unit, rounded up so the maximum hits the last entry
+    _step = ((Size << 16) + RGBWW_CALC_MAXVAL - 1) / RGBWW_CALC_MAXVAL;
+
+    _identity = (curve == Curve::Linear);
+    for (unsigned ch=0; ch < NumChannels; ++ch) {
+        if (brightness[ch] != 100)
+            _identity = false;
+        _brightness[ch] = (constrain(brightness[ch], 0, 100) << 16) / 100;
+    }
+
+    const float g = constrain(gamma, 10, 500) / 100.0f;
+    for (unsigned i=0; i <= Size; ++i) {
+        const float x = float(i) / Size;
+        float y;
+        switch(curve) {
+        case Curve::Cie1931:
+            y = cie1931(x);
+            break;
+        case Curve::Gamma:
+            y = powf(x, g);
+            break;
+        default:
+            y = x;
+            break;
+        }
+
+        for (unsigned ch=0; ch < NumChannels; ++ch) {
+            const float out = y * constrain(brightness[ch], 0, 100) / 100.0f * (RGBWW_CALC_MAXVAL << FracBits);
+            _tables[ch][i] = static_cast<uint16_t>(out + 0.5f);
+        }
+    }
+}
+
+void OutputLut::setDithering(uint8_t mask) {
+    _ditherMask = mask;
+    memset(_ditherError, 0, sizeof(_ditherError));
+}
+
+OutputLut::Kernel OutputLut::kernelFor(int colorMode) {
+#ifdef APP_FIXED_COLORMODE
+    // only the configured variant is instantiated
+    (void)colorMode;
+    return &applyKernel<static_cast<RGBWW_COLORMODE>(APP_FIXED_COLORMODE)>;
+#else
+    switch(colorMode) {
+    case RGBWW:
+        return &applyKernel<RGBWW>;
+    case RGBCW:
+        return &applyKernel<RGBCW>;
+    case RGBWWCW:
+        return &applyKernel<RGBWWCW>;
+    default:
+        return &applyKernel<RGB>;
+    }
+#endif
+}
+
+OutputLut::Curve OutputLut::curveFromName(const String& name) {
+    if (name == "cie1931")
+        return Curve::Cie1931;
+    else if (name == "gamma")
+        return Curve::Gamma;
+    else
+        return Curve::Linear;
+}
@@ -0,0 +1,31 @@
+#include <RGBWWCtrl.h>
+
+void PowerLimiter::configure(const int currentMa[NumChannels], int budgetMa) {
+    _hasModel = false;
+    for (unsigned i=0; i < NumChannels; ++i) {
+        const uint32_t ma = constrain(currentMa[i], 0, 20000);
+        _coef[i] = ((ma << 10) + RGBWW_CALC_MAXVAL / 2) / RGBWW_CALC_MAXVAL;
+        if (ma > 0)
+            _hasModel = true;
+    }
+
+    _budget = _hasModel ? constrain(budgetMa, 0, 100000) : 0;
+    _current = 0;
+    _limited = false;
+}
+
+void PowerLimiter::apply(ChannelOutput& output) {
+    _current = estimate(output);
+    _limited = (_budget > 0 && _current > _budget);
+    if (!_limited)
+        return;
+
+    // the only division, and only while limiting
+    const uint32_t scale = (_budget << 12) / _current;
+    output.r = (output.r * scale) >> 12;
+    output.g = (output.g * scale) >> 12;
+    output.b = (output.b * scale) >> 12;
+    output.ww = (output.ww * scale) >> 12;
+    output.cw = (output.cw * scale) >> 12;
+    _current = estimate(output);
+}
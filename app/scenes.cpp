@@ -0,0 +1,66 @@
+#include <RGBWWCtrl.h>
+
+
+bool SceneStorage::isValidId(uint8_t id) {
+    return id < APP_SCENES_MAX;
+}
+
+bool SceneStorage::ensureFile() {
+    file_t file = fileOpen(APP_SCENES_FILE, eFO_ReadWrite | eFO_CreateIfNotExist);
+    if (file < 0) {
+        debug_e("SceneStorage: cannot open %s", APP_SCENES_FILE);
+        return false;
+    }
+
+    // pad the file to the full table so every slot can be addressed by seek
+    const int tableSize = APP_SCENES_MAX * sizeof(Scene);
+    int size = fileSeek(file, 0, eSO_FileEnd);
+    const Scene empty;
+    while (size >= 0 && size < tableSize) {
+        if (fileWrite(file, &empty, sizeof(empty)) != sizeof(empty)) {
+            size = -1;
+            break;
+        }
+        size += sizeof(empty);
+    }
+
+    fileClose(file);
+    return size >= tableSize;
+}
+
+bool SceneStorage::load(uint8_t id, Scene& scene) {
+    if (!isValidId(id))
+        return false;
+
+    file_t file = fileOpen(APP_SCENES_FILE, eFO_ReadOnly);
+    if (file < 0)
+        return false;
+
+    bool ok = fileSeek(file, id * sizeof(Scene), eSO_FileStart) >= 0 &&
+            fileRead(file, &scene, sizeof(Scene)) == sizeof(Scene);
+    fileClose(file);
+
+    return ok && scene.used && scene.numSteps > 0 && scene.numSteps <= APP_SCENE_MAXSTEPS;
+}
+
+bool SceneStorage::save(uint8_t id, const Scene& scene) {
+    if (!isValidId(id) || !ensureFile())
+        return false;
+
+    debug_d("SceneStorage: saving scene %d", id);
+    file_t file = fileOpen(APP_SCENES_FILE, eFO_ReadWrite);
+    if (file < 0)
+        return false;
+
+    bool ok = fileSeek(file, id * sizeof(Scene), eSO_FileStart) >= 0 &&
+            fileWrite(file, &scene, sizeof(Scene)) == sizeof(Scene);
+    fileClose(file);
+    return ok;
+}
+
+bool SceneStorage::remove(uint8_t id) {
+    if (!isValidId(id) || !fileExist(APP_SCENES_FILE))
+        return false;
+
+    return save(id, Scene());
+}
@@ -0,0 +1,280 @@
+#include <RGBWWCtrl.h>
+
+namespace {
+    const char sequenceMagic[3] = { 'R', 'W', 'S' };
+
+    inline uint16_t readU16(const uint8_t* p) {
+        return p[0] | (p[1] << 8);
+    }
+
+    inline uint32_t readU32(const uint8_t* p) {
+        return readU16(p) | (static_cast<uint32_t>(readU16(p + 2)) << 16);
+    }
+
+    inline String sequenceFile(const String& name) {
+        return String(APP_SEQUENCE_FILEPREFIX) + name;
+    }
+}
+
+size_t SequencePlayer::instructionSize(uint8_t opcode) {
+    switch(opcode) {
+    case End:
+    case EndLoop:
+        return 1;
+    case FadeHsv:
+        return 1 + 4 * 2 + 4;
+    case FadeRaw:
+        return 1 + 5 * 2 + 4;
+    case Hold:
+        return 1 + 4;
+    case Loop:
+    case Channels:
+        return 1 + 2;
+    case Ease:
+        return 1 + 1;
+    default:
+        return 0;
+    }
+}
+
+bool SequencePlayer::isValidName(const String& name) {
+    if (name.length() == 0 || name.length() > APP_SEQUENCE_MAXNAMELEN)
+        return false;
+
+    for (unsigned i=0; i < name.length(); ++i) {
+        const char c = name[i];
+        if (!isalnum(c) && c != '_' && c != '-')
+            return false;
+    }
+    return true;
+}
+
+void SequencePlayer::writeHeader(String& program) {
+    program = "";
+    for (char c : sequenceMagic)
+        program += c;
+    program += static_cast<char>(Version);
+}
+
+bool SequencePlayer::validate(const String& program, String& msg) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(program.c_str());
+    const size_t len = program.length();
+    if (len <= HeaderSize || len > APP_SEQUENCE_MAXSIZE) {
+        msg = "Invalid sequence size";
+        return false;
+    }
+
+    if (memcmp(data, sequenceMagic, sizeof(sequenceMagic)) != 0 || data[3] != Version) {
+        msg = "Invalid sequence header";
+        return false;
+    }
+
+    int depth = 0;
+    for (size_t pos = HeaderSize; pos < len; ) {
+        const uint8_t op = data[pos];
+        const size_t size = instructionSize(op);
+        if (size == 0 || pos + size > len) {
+            msg = "Invalid instruction at ";
+            msg += pos;
+            return false;
+        }
+
+        if (op == Loop) {
+            if (++depth > APP_SEQUENCE_MAXLOOPDEPTH) {
+                msg = "Loops nested too deep";
+                return false;
+            }
+        }
+        else if (op == EndLoop) {
+            if (--depth < 0) {
+                msg = "Unbalanced loop";
+                return false;
+            }
+        }
+        else if (op == Ease && data[pos + 1] >= Easing::NumCurves) {
+            msg = "Invalid easing";
+            return false;
+        }
+        else if (op == End) {
+            if (depth != 0) {
+                msg = "Unbalanced loop";
+                return false;
+            }
+            return true;
+        }
+        pos += size;
+    }
+
+    msg = "Missing end";
+    return false;
+}
+
+bool SequencePlayer::store(const String& name, const String& program, String& msg) {
+    if (!isValidName(name)) {
+        msg = "Invalid sequence name";
+        return false;
+    }
+
+    if (!validate(program, msg))
+        return false;
+
+    debug_d("SequencePlayer::store: %s (%d bytes)", name.c_str(), program.length());
+    if (fileSetContent(sequenceFile(name), program) != static_cast<int>(program.length())) {
+        msg = "Saving sequence failed";
+        return false;
+    }
+    return true;
+}
+
+bool SequencePlayer::start(const String& name) {
+    if (!isValidName(name))
+        return false;
+
+    // a missing sequence leaves the running one alone
+    const file_t file = fileOpen(sequenceFile(name), eFO_ReadOnly);
+    if (file < 0)
+        return false;
+
+    close();
+    _file = file;
+    _windowStart = 0;
+    _windowLen = 0;
+    _windowAtEnd = false;
+    _name = name;
+    _pc = HeaderSize;
+    _loopDepth = 0;
+    _channels = 0;
+    _ease = Easing::Linear;
+    _transition.stop();
+    _steps = 0;
+    _elapsed = 0;
+    _active = true;
+    return true;
+}
+
+void SequencePlayer::stop() {
+    _transition.stop();
+    _active = false;
+    close();
+}
+
+void SequencePlayer::close() {
+    if (_file >= 0) {
+        fileClose(_file);
+        _file = -1;
+    }
+}
+
+const uint8_t* SequencePlayer::fetch() {
+    // refill when the instruction may reach past the window, unless the window holds the end of the file
+    if (_pc < _windowStart || (!_windowAtEnd && _pc + MaxInstructionSize > _windowStart + _windowLen)) {
+        if (_file < 0 || fileSeek(_file, _pc, eSO_FileStart) < 0)
+            return nullptr;
+
+        const int len = fileRead(_file, _window, sizeof(_window));
+        if (len <= 0)
+            return nullptr;
+
+        _windowStart = _pc;
+        _windowLen = len;
+        _windowAtEnd = static_cast<size_t>(len) < sizeof(_window);
+    }
+
+    const uint32_t offset = _pc - _windowStart;
+    if (offset >= _windowLen)
+        return nullptr;
+
+    const uint8_t* buf = _window + offset;
+    const size_t size = instructionSize(buf[0]);
+    if (size == 0 || offset + size > _windowLen)
+        return nullptr;
+    return buf;
+}
+
+bool SequencePlayer::execute(RGBWWLed& led) {
+    const uint8_t* buf = fetch();
+    if (buf == nullptr)
+        return false;
+
+    const uint8_t op = buf[0];
+    _pc += instructionSize(op);
+    _elapsed = 0;
+    _steps = 0;
+
+    switch(op) {
+    case FadeHsv:
+    {
+        HSVCT to;
+        to.h = readU16(buf + 1);
+        to.s = readU16(buf + 3);
+        to.v = readU16(buf + 5);
+        to.ct = readU16(buf + 7);
+        _transition.startHsv(led.getCurrentColor(), to, readU32(buf + 9), _ease, _channels);
+        break;
+    }
+    case FadeRaw:
+    {
+        ChannelOutput to;
+        to.r = readU16(buf + 1);
+        to.g = readU16(buf + 3);
+        to.b = readU16(buf + 5);
+        to.ww = readU16(buf + 7);
+        to.cw = readU16(buf + 9);
+        _transition.startRaw(led.getCurrentOutput(), to, readU32(buf + 11), _ease, _channels);
+        break;
+    }
+    case Hold:
+        _steps = readU32(buf + 1) / RGBWW_MINTIMEDIFF;
+        break;
+    case Loop:
+        if (_loopDepth < APP_SEQUENCE_MAXLOOPDEPTH) {
+            _loops[_loopDepth].begin = _pc;
+            _loops[_loopDepth].remaining = readU16(buf + 1);
+            ++_loopDepth;
+        }
+        break;
+    case EndLoop:
+        if (_loopDepth > 0) {
+            // a count of 0 repeats forever
+            LoopState& loop = _loops[_loopDepth - 1];
+            if (loop.remaining == 0 || --loop.remaining > 0)
+                _pc = loop.begin;
+            else
+                --_loopDepth;
+        }
+        break;
+    case Channels:
+        _channels = readU16(buf + 1);
+        break;
+    case Ease:
+        _ease = buf[1];
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+bool SequencePlayer::process(RGBWWLed& led) {
+    if (!_active)
+        return false;
+
+    // run untimed instructions until a fade or hold is pending, a few per step at most
+    // so that a loop without any timed instruction cannot block the LED timer
+    unsigned budget = 8;
+    while (!_transition.isActive() && _elapsed >= _steps) {
+        if (budget-- == 0)
+            return true;
+
+        if (!execute(led)) {
+            stop();
+            return false;
+        }
+    }
+
+    if (_transition.isActive())
+        _transition.process(led);
+    else
+        ++_elapsed;
+    return true;
+}
@@ -2,37 +2,163 @@
 #include <algorithm>
 
 uint32_t StepSync::reset() {
+    // the master restarted: relock the phase, the frequency error of our timer did not change
     _firstMasterSync = true;
     _catchupOffset = 0;
-    _steering = 1.0;
-    return _constBaseInt;
+    _lockCount = 0;
+    _locked = false;
+    _hasMaster = false;
+    _interval = frequencyInterval();
+    resetBaseline();
+    return _interval;
 }
 
-uint32_t StepSync::onMasterClock(uint32_t stepsCurrent, uint32_t stepsMaster) {
-    uint32_t nextInt = _constBaseInt;
-    if (!_firstMasterSync) {
-        int diff = StepSync::calcOverflowVal(_stepsSyncLast, stepsCurrent);
-        int masterDiff = StepSync::calcOverflowVal(_stepsSyncMasterLast, stepsMaster);
+void StepSync::resetBaseline() {
+    _baselineMasterSteps = 0;
+    _baselineLocalUs = 0;
+}
 
-        int curOffset = masterDiff - diff;
-        _catchupOffset += curOffset;
-        debug_i("Diff: %d | Master Diff: %d | CurOffset: %d | Catchup Offset: %d\n", diff, masterDiff, curOffset, _catchupOffset);
+void StepSync::updateDrift(int masterDiff, int diff) {
+    // local time in timer microseconds at the interval we ran with. Steps lost to
+    // a blocked timer only show up as phase offset, the drift estimate ignores them.
+    _baselineMasterSteps += masterDiff;
+    _baselineLocalUs += static_cast<uint64_t>(diff) * _interval;
 
-        float curSteering = 1.0 - static_cast<float>(_catchupOffset) / masterDiff;
-        curSteering = std::min(std::max(curSteering, 0.5f), 1.5f);
-        _steering = 0.5f *_steering + 0.5f * curSteering;
-        nextInt *= _steering;
-        debug_i("New Int: %d | CurSteering: %f | Steering: %f\n", nextInt, curSteering, _steering);
+    // forget old data slowly, so the estimate follows the crystal when its temperature changes
+    if (_baselineMasterSteps > _maxBaselineSteps) {
+        _baselineMasterSteps /= 2;
+        _baselineLocalUs /= 2;
     }
 
+    if (_baselineMasterSteps < _minBaselineSteps)
+        return;
+
+    const int64_t masterUs = static_cast<int64_t>(_baselineMasterSteps) * _constBaseInt;
+    const int drift = (masterUs * 1000000) / static_cast<int64_t>(_baselineLocalUs) - 1000000;
+    if (abs(drift) <= _maxDriftPpm) {
+        _driftPpm = drift;
+        _driftValid = true;
+    }
+}
+
+uint32_t StepSync::frequencyInterval() const {
+    return (static_cast<int64_t>(_constBaseInt) * 1000000) / (1000000 + _driftPpm);
+}
+
+uint32_t StepSync::onMasterClock(uint32_t stepsCurrent, uint32_t stepsMaster, int32_t subStepUs) {
+    // switching between a clock with and without sub-step phase must not move the phase
+    const bool hasSubStep = (subStepUs != NoSubStep);
+    if (!hasSubStep)
+        subStepUs = _subStepRefUs;
+    else if (!_hasSubStep)
+        _subStepRefUs = subStepUs;
+    _hasSubStep = hasSubStep;
+
+    if (_firstMasterSync) {
+        _stepsSyncMasterLast = stepsMaster;
+        _stepsSyncLast = stepsCurrent;
+        _firstMasterSync = false;
+        _masterOffset = stepsMaster - stepsCurrent;
+        _subStepRefUs = subStepUs;
+        _hasMaster = true;
+        _interval = frequencyInterval();
+        return _interval;
+    }
+
+    const int diff = StepSync::calcOverflowVal(_stepsSyncLast, stepsCurrent);
+    const int masterDiff = StepSync::calcOverflowVal(_stepsSyncMasterLast, stepsMaster);
     _stepsSyncMasterLast = stepsMaster;
     _stepsSyncLast = stepsCurrent;
-    _firstMasterSync = false;
 
-    return nextInt;
+    // a master counter far off the time we measured locally means the master restarted
+    const int64_t expected = (static_cast<int64_t>(diff) * _interval) / _constBaseInt;
+    if (diff <= 0 || masterDiff <= 0 || std::abs(masterDiff - expected) > expected / 2) {
+        debug_w("StepSync: implausible master clock (%d steps in %d), relocking phase", masterDiff, diff);
+        reset();
+        _firstMasterSync = false;
+        _masterOffset = stepsMaster - stepsCurrent;
+        _subStepRefUs = subStepUs;
+        _hasMaster = true;
+        return _interval;
+    }
+
+    updateDrift(masterDiff, diff);
+
+    _masterOffset = stepsMaster - stepsCurrent;
+
+    const int curOffset = masterDiff - diff;
+    _catchupOffset += curOffset;
+
+    // remove half of the phase offset during the next sync period. In microseconds, so
+    // an offset of a single step is not truncated to no correction at all.
+    const int64_t periodUs = static_cast<int64_t>(masterDiff) * _constBaseInt;
+    const int64_t offsetUs = static_cast<int64_t>(_catchupOffset) * _constBaseInt + (subStepUs - _subStepRefUs);
+    int64_t correctionUs = offsetUs / 2;
+    correctionUs = std::min(std::max(correctionUs, -periodUs / 4), periodUs / 4);
+    _interval = (frequencyInterval() * periodUs) / (periodUs + correctionUs);
+
+    const int absOffset = abs(_catchupOffset);
+    if (absOffset <= _lockOffset) {
+        if (_lockCount < 2 && ++_lockCount == 2)
+            _locked = true;
+    }
+    else if (absOffset > _unlockOffset) {
+        _lockCount = 0;
+        _locked = false;
+    }
+
+    debug_d("StepSync: diff: %d | master diff: %d | offset: %d | drift: %d ppm | interval: %u | locked: %d",
+            diff, masterDiff, _catchupOffset, _driftPpm, _interval, _locked);
+
+    // the flash is only written every few hours, or right away for a large change like the first estimate
+    _stepsSinceSave += diff;
+    const int change = abs(_driftPpm - _savedDriftPpm);
+    if (_locked && _driftValid && (change >= _saveLargeDeviationPpm ||
+            (change >= _saveDeviationPpm && _stepsSinceSave >= _saveIntervalSteps)))
+        save();
+
+    return _interval;
 }
 
 int StepSync::getCatchupOffset() const {
     return _catchupOffset;
 }
 
+bool StepSync::toLocalSteps(uint32_t masterSteps, uint32_t& steps) const {
+    steps = masterSteps - _masterOffset;
+    return _hasMaster;
+}
+
+bool StepSync::toMasterSteps(uint32_t steps, uint32_t& masterSteps) const {
+    masterSteps = steps + _masterOffset;
+    return _hasMaster;
+}
+
+void StepSync::load() {
+    StaticJsonDocument<64> doc;
+    if (!Json::loadFromFile(doc, APP_STEPSYNC_FILE))
+        return;
+
+    const int drift = doc["drift_ppm"] | 0;
+    if (abs(drift) <= _maxDriftPpm) {
+        _driftPpm = drift;
+        _savedDriftPpm = drift;
+        _driftValid = true;
+        _interval = frequencyInterval();
+    }
+}
+
+void StepSync::save() {
+    debug_d("StepSync: saving drift %d ppm", _driftPpm);
+    StaticJsonDocument<64> doc;
+    doc["drift_ppm"] = _driftPpm;
+    if (Json::saveToFile(doc, APP_STEPSYNC_FILE)) {
+        _savedDriftPpm = _driftPpm;
+        _stepsSinceSave = 0;
+    }
+}
+
+void StepSync::flush() {
+    if (_driftValid && _driftPpm != _savedDriftPpm)
+        save();
+}
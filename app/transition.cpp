@@ -0,0 +1,156 @@
+#include <RGBWWCtrl.h>
+
+#include <algorithm>
+
+void Transition::start(uint32_t ms, uint8_t ease, ChannelMask channels) {
+    // at least one step so that the target is always reached
+    _steps = std::max(ms / RGBWW_MINTIMEDIFF, 1u);
+    _elapsed = 0;
+    _ease = ease;
+    _channels = channels;
+    _active = true;
+}
+
+void Transition::startHsv(const HSVCT& from, const HSVCT& to, uint32_t ms, uint8_t ease, ChannelMask channels, int direction) {
+    _space = Space::Hsv;
+    _from[0] = from.h;
+    _from[1] = from.s;
+    _from[2] = from.v;
+    _from[3] = from.ct;
+    _to[0] = to.h;
+    _to[1] = to.s;
+    _to[2] = to.v;
+    _to[3] = to.ct;
+
+    // hue takes the shorter way around the wheel, or the other way round for direction 0
+    int dh = _to[0] - _from[0];
+    if (dh > RGBWW_CALC_HUEWHEELMAX / 2)
+        dh -= RGBWW_CALC_HUEWHEELMAX;
+    else if (dh < -RGBWW_CALC_HUEWHEELMAX / 2)
+        dh += RGBWW_CALC_HUEWHEELMAX;
+    if (direction == 0 && dh != 0)
+        dh += (dh > 0) ? -RGBWW_CALC_HUEWHEELMAX : RGBWW_CALC_HUEWHEELMAX;
+    _to[0] = _from[0] + dh;
+
+    start(ms, ease, channels);
+}
+
+void Transition::startRaw(const ChannelOutput& from, const ChannelOutput& to, uint32_t ms, uint8_t ease, ChannelMask channels) {
+    _space = Space::Raw;
+    _from[0] = from.r;
+    _from[1] = from.g;
+    _from[2] = from.b;
+    _from[3] = from.ww;
+    _from[4] = from.cw;
+    _to[0] = to.r;
+    _to[1] = to.g;
+    _to[2] = to.b;
+    _to[3] = to.ww;
+    _to[4] = to.cw;
+    start(ms, ease, channels);
+}
+
+void Transition::startOklab(const ChannelOutput& from, const ChannelOutput& to, uint32_t ms, uint8_t ease) {
+    _space = Space::Oklab;
+    const Oklab::Lab labFrom = Oklab::fromRgb(from.r, from.g, from.b);
+    const Oklab::Lab labTo = Oklab::fromRgb(to.r, to.g, to.b);
+    _from[0] = labFrom.L;
+    _from[1] = labFrom.a;
+    _from[2] = labFrom.b;
+    _from[3] = from.ww;
+    _from[4] = from.cw;
+    _to[0] = labTo.L;
+    _to[1] = labTo.a;
+    _to[2] = labTo.b;
+    _to[3] = to.ww;
+    _to[4] = to.cw;
+
+    _rawTarget = to;
+    _hasHsvTarget = false;
+    start(ms, ease, 0);
+}
+
+void Transition::startOklab(const ChannelOutput& from, const ChannelOutput& to, const HSVCT& hsvTarget, uint32_t ms, uint8_t ease) {
+    startOklab(from, to, ms, ease);
+    _hsvTarget = hsvTarget;
+    _hasHsvTarget = true;
+}
+
+bool Transition::process(RGBWWLed& led) {
+    if (!_active)
+        return false;
+
+    ++_elapsed;
+    if (_elapsed >= _steps) {
+        finish(led);
+        _active = false;
+        return false;
+    }
+
+    const uint16_t progress = Easing::apply(_ease, static_cast<uint16_t>((static_cast<uint64_t>(_elapsed) << 16) / _steps));
+    int val[5];
+    for (unsigned i=0; i < 5; ++i)
+        val[i] = _from[i] + static_cast<int32_t>((static_cast<int64_t>(_to[i] - _from[i]) * progress) >> 16);
+    write(led, val);
+    return true;
+}
+
+void Transition::finish(RGBWWLed& led) {
+    if (_space != Space::Oklab) {
+        write(led, _to);
+        return;
+    }
+
+    // Lab values are rounded, so the end point is written as given
+    if (_hasHsvTarget) {
+        led.colorDirectHSV(_hsvTarget);
+    }
+    else {
+        led.colorDirectRAW(_rawTarget);
+    }
+}
+
+void Transition::write(RGBWWLed& led, const int val[5]) {
+    if (_space == Space::Oklab) {
+        Oklab::Lab lab;
+        lab.L = val[0];
+        lab.a = val[1];
+        lab.b = val[2];
+        int r, g, b;
+        Oklab::toRgb(lab, r, g, b);
+
+        RequestChannelOutput output;
+        output.r = AbsOrRelValue(r);
+        output.g = AbsOrRelValue(g);
+        output.b = AbsOrRelValue(b);
+        output.ww = AbsOrRelValue(val[3]);
+        output.cw = AbsOrRelValue(val[4]);
+        led.colorDirectRAW(output);
+    }
+    else if (_space == Space::Hsv) {
+        RequestHSVCT color;
+        if (hasChannel(_channels, CtrlChannel::Hue))
+            color.h = AbsOrRelValue((val[0] + RGBWW_CALC_HUEWHEELMAX) % RGBWW_CALC_HUEWHEELMAX);
+        if (hasChannel(_channels, CtrlChannel::Sat))
+            color.s = AbsOrRelValue(val[1]);
+        if (hasChannel(_channels, CtrlChannel::Val))
+            color.v = AbsOrRelValue(val[2]);
+        if (hasChannel(_channels, CtrlChannel::ColorTemp))
+            color.ct = AbsOrRelValue(val[3]);
+        led.colorDirectHSV(color);
+    }
+    else {
+        RequestChannelOutput output;
+        if (hasChannel(_channels, CtrlChannel::Red))
+            output.r = AbsOrRelValue(val[0]);
+        if (hasChannel(_channels, CtrlChannel::Green))
+            output.g = AbsOrRelValue(val[1]);
+        if (hasChannel(_channels, CtrlChannel::Blue))
+            output.b = AbsOrRelValue(val[2]);
+        if (hasChannel(_channels, CtrlChannel::WarmWhite))
+            output.ww = AbsOrRelValue(val[3]);
+        if (hasChannel(_channels, CtrlChannel::ColdWhite))
+            output.cw = AbsOrRelValue(val[4]);
+        led.colorDirectRAW(output);
+    }
+}
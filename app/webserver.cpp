@@ -60,6 +60,11 @@ void ApplicationWebserver::init() {
     paths.set("/blink", HttpPathDelegate(&ApplicationWebserver::onBlink, this));
 
     paths.set("/toggle", HttpPathDelegate(&ApplicationWebserver::onToggle, this));
+    paths.set("/scene", HttpPathDelegate(&ApplicationWebserver::onScene, this));
+    paths.set("/effect", HttpPathDelegate(&ApplicationWebserver::onEffect, this));
+    paths.set("/scenes", HttpPathDelegate(&ApplicationWebserver::onScenes, this));
+    paths.set("/sequence", HttpPathDelegate(&ApplicationWebserver::onSequence, this));
+    paths.set("/sequences", HttpPathDelegate(&ApplicationWebserver::onSequences, this));
     _init = true;
 }
 
@@ -423,6 +428,37 @@ void ApplicationWebserver::onConfig(HttpRequest &request, HttpResponse &response
         	if (!jcoltemp.isNull()) {
         		color_updated |= Json::getValueChanged(jcoltemp["ww"], app.cfg.color.colortemp.ww);
         		color_updated |= Json::getValueChanged(jcoltemp["cw"], app.cfg.color.colortemp.cw);
+        		color_updated |= Json::getValueChanged(jcoltemp["table"], app.cfg.color.colortemp.table);
+        		color_updated |= Json::getValueChanged(jcoltemp["rgb_assist"], app.cfg.color.colortemp.rgb_assist);
+            }
+
+        	JsonObject jdim = jcol["dimming"];
+        	if (!jdim.isNull()) {
+        		color_updated |= Json::getValueChanged(jdim["curve"], app.cfg.color.dimming.curve);
+        		color_updated |= Json::getValueChanged(jdim["gamma"], app.cfg.color.dimming.gamma);
+            }
+
+        	JsonObject jdit = jcol["dithering"];
+        	if (!jdit.isNull()) {
+        		color_updated |= Json::getValueChanged(jdit["red"], app.cfg.color.dithering.red);
+        		color_updated |= Json::getValueChanged(jdit["green"], app.cfg.color.dithering.green);
+        		color_updated |= Json::getValueChanged(jdit["blue"], app.cfg.color.dithering.blue);
+        		color_updated |= Json::getValueChanged(jdit["ww"], app.cfg.color.dithering.ww);
+        		color_updated |= Json::getValueChanged(jdit["cw"], app.cfg.color.dithering.cw);
+            }
+
+        	JsonObject jcal = jcol["calibration"];
+        	if (!jcal.isNull()) {
+        		JsonArray jrgb = jcal["rgb"];
+        		if (jrgb.size() == 9) {
+        			for (unsigned i=0; i < 9; ++i)
+        				color_updated |= Json::getValueChanged(jrgb[i], app.cfg.color.calibration.rgb[i]);
+        		}
+        		JsonArray jwhite = jcal["white"];
+        		if (jwhite.size() == 4) {
+        			for (unsigned i=0; i < 4; ++i)
+        				color_updated |= Json::getValueChanged(jwhite[i], app.cfg.color.calibration.white[i]);
+        		}
             }
         }
 
@@ -460,6 +496,8 @@ void ApplicationWebserver::onConfig(HttpRequest &request, HttpResponse &response
             Json::getBoolTolerant(jntp["enabled"], app.cfg.ntp.enabled);
             Json::getValue(jntp["server"], app.cfg.ntp.server);
             Json::getValue(jntp["interval"], app.cfg.ntp.interval);
+            Json::getBoolTolerant(jntp["step_sync"], app.cfg.ntp.step_sync);
+            Json::getValue(jntp["step_interval"], app.cfg.ntp.step_interval);
         }
 
         JsonObject jsync = root["sync"];
@@ -468,12 +506,21 @@ void ApplicationWebserver::onConfig(HttpRequest &request, HttpResponse &response
         	Json::getValue(jsync["clock_master_interval"], app.cfg.sync.clock_master_interval);
         	Json::getBoolTolerant(jsync["clock_slave_enabled"], app.cfg.sync.clock_slave_enabled);
         	Json::getValue(jsync["clock_slave_topic"], app.cfg.sync.clock_slave_topic);
+        	Json::getBoolTolerant(jsync["clock_udp_enabled"], app.cfg.sync.clock_udp_enabled);
+        	Json::getValue(jsync["clock_udp_group"], app.cfg.sync.clock_udp_group);
+        	Json::getValue(jsync["clock_udp_port"], app.cfg.sync.clock_udp_port);
+        	Json::getBoolTolerant(jsync["clock_election_enabled"], app.cfg.sync.clock_election_enabled);
+        	Json::getValue(jsync["clock_election_topic"], app.cfg.sync.clock_election_topic);
         	Json::getBoolTolerant(jsync["cmd_master_enabled"], app.cfg.sync.cmd_master_enabled);
+        	Json::getValue(jsync["cmd_lead_ms"], app.cfg.sync.cmd_lead_ms);
         	Json::getBoolTolerant(jsync["cmd_slave_enabled"], app.cfg.sync.cmd_slave_enabled);
         	Json::getValue(jsync["cmd_slave_topic"], app.cfg.sync.cmd_slave_topic);
+        	Json::getValue(jsync["cmd_groups"], app.cfg.sync.cmd_groups);
+        	Json::getBoolTolerant(jsync["cmd_broadcast_enabled"], app.cfg.sync.cmd_broadcast_enabled);
 
         	Json::getBoolTolerant(jsync["color_master_enabled"], app.cfg.sync.color_master_enabled);
         	Json::getValue(jsync["color_master_interval_ms"], app.cfg.sync.color_master_interval_ms);
+        	Json::getBoolTolerant(jsync["color_master_binary"], app.cfg.sync.color_master_binary);
         	Json::getBoolTolerant(jsync["color_slave_enabled"], app.cfg.sync.color_slave_enabled);
         	Json::getValue(jsync["color_slave_topic"], app.cfg.sync.color_slave_topic);
         }
@@ -486,6 +533,23 @@ void ApplicationWebserver::onConfig(HttpRequest &request, HttpResponse &response
         	Json::getValue(jevents["transfin_interval_ms"], app.cfg.events.transfin_interval_ms);
         }
 
+        JsonObject jpower = root["power"];
+        if (!jpower.isNull()) {
+        	color_updated |= Json::getValueChanged(jpower["red_ma"], app.cfg.power.red_ma);
+        	color_updated |= Json::getValueChanged(jpower["green_ma"], app.cfg.power.green_ma);
+        	color_updated |= Json::getValueChanged(jpower["blue_ma"], app.cfg.power.blue_ma);
+        	color_updated |= Json::getValueChanged(jpower["ww_ma"], app.cfg.power.ww_ma);
+        	color_updated |= Json::getValueChanged(jpower["cw_ma"], app.cfg.power.cw_ma);
+        	color_updated |= Json::getValueChanged(jpower["budget_ma"], app.cfg.power.budget_ma);
+        	color_updated |= Json::getValueChanged(jpower["voltage_mv"], app.cfg.power.voltage_mv);
+        }
+
+        JsonObject jenergy = root["energy"];
+        if (!jenergy.isNull()) {
+        	Json::getValue(jenergy["save_interval_min"], app.cfg.energy.save_interval_min);
+        	Json::getValue(jenergy["publish_interval_s"], app.cfg.energy.publish_interval_s);
+        }
+
         app.cfg.sanitizeValues();
 
         // update and save settings if we haven`t received any error until now
@@ -575,6 +639,27 @@ void ApplicationWebserver::onConfig(HttpRequest &request, HttpResponse &response
         JsonObject ctmp = color.createNestedObject("colortemp");
         ctmp["ww"] = app.cfg.color.colortemp.ww;
         ctmp["cw"] = app.cfg.color.colortemp.cw;
+        ctmp["table"] = app.cfg.color.colortemp.table;
+        ctmp["rgb_assist"] = app.cfg.color.colortemp.rgb_assist;
+
+        JsonObject dim = color.createNestedObject("dimming");
+        dim["curve"] = app.cfg.color.dimming.curve;
+        dim["gamma"] = app.cfg.color.dimming.gamma;
+
+        JsonObject dit = color.createNestedObject("dithering");
+        dit["red"] = app.cfg.color.dithering.red;
+        dit["green"] = app.cfg.color.dithering.green;
+        dit["blue"] = app.cfg.color.dithering.blue;
+        dit["ww"] = app.cfg.color.dithering.ww;
+        dit["cw"] = app.cfg.color.dithering.cw;
+
+        JsonObject cal = color.createNestedObject("calibration");
+        JsonArray calRgb = cal.createNestedArray("rgb");
+        for (float v : app.cfg.color.calibration.rgb)
+            calRgb.add(v);
+        JsonArray calWhite = cal.createNestedArray("white");
+        for (float v : app.cfg.color.calibration.white)
+            calWhite.add(v);
 
         JsonObject s = json.createNestedObject("security");
         s["api_secured"] = app.cfg.general.api_secured;
@@ -587,15 +672,37 @@ void ApplicationWebserver::onConfig(HttpRequest &request, HttpResponse &response
         sync["clock_master_interval"] = app.cfg.sync.clock_master_interval;
         sync["clock_slave_enabled"] = app.cfg.sync.clock_slave_enabled;
         sync["clock_slave_topic"] = app.cfg.sync.clock_slave_topic;
+        sync["clock_udp_enabled"] = app.cfg.sync.clock_udp_enabled;
+        sync["clock_udp_group"] = app.cfg.sync.clock_udp_group;
+        sync["clock_udp_port"] = app.cfg.sync.clock_udp_port;
+        sync["clock_election_enabled"] = app.cfg.sync.clock_election_enabled;
+        sync["clock_election_topic"] = app.cfg.sync.clock_election_topic;
         sync["cmd_master_enabled"] = app.cfg.sync.cmd_master_enabled;
+        sync["cmd_lead_ms"] = app.cfg.sync.cmd_lead_ms;
         sync["cmd_slave_enabled"] = app.cfg.sync.cmd_slave_enabled;
         sync["cmd_slave_topic"] = app.cfg.sync.cmd_slave_topic;
+        sync["cmd_groups"] = app.cfg.sync.cmd_groups;
+        sync["cmd_broadcast_enabled"] = app.cfg.sync.cmd_broadcast_enabled;
 
         sync["color_master_enabled"] = app.cfg.sync.color_master_enabled;
         sync["color_master_interval_ms"] = app.cfg.sync.color_master_interval_ms;
+        sync["color_master_binary"] = app.cfg.sync.color_master_binary;
         sync["color_slave_enabled"] = app.cfg.sync.color_slave_enabled;
         sync["color_slave_topic"] = app.cfg.sync.color_slave_topic;
 
+        JsonObject power = json.createNestedObject("power");
+        power["red_ma"] = app.cfg.power.red_ma;
+        power["green_ma"] = app.cfg.power.green_ma;
+        power["blue_ma"] = app.cfg.power.blue_ma;
+        power["ww_ma"] = app.cfg.power.ww_ma;
+        power["cw_ma"] = app.cfg.power.cw_ma;
+        power["budget_ma"] = app.cfg.power.budget_ma;
+        power["voltage_mv"] = app.cfg.power.voltage_mv;
+
+        JsonObject energy = json.createNestedObject("energy");
+        energy["save_interval_min"] = app.cfg.energy.save_interval_min;
+        energy["publish_interval_s"] = app.cfg.energy.publish_interval_s;
+
         JsonObject events = json.createNestedObject("events");
         events["color_interval_ms"] = app.cfg.events.color_interval_ms;
         events["color_mininterval_ms"] = app.cfg.events.color_mininterval_ms;
@@ -648,6 +755,34 @@ void ApplicationWebserver::onInfo(HttpRequest &request, HttpResponse &response)
     rgbww["version"] = RGBWW_VERSION;
     rgbww["queuesize"] = RGBWW_ANIMATIONQSIZE;
 
+    JsonObject cmdCache = data.createNestedObject("cmd_cache");
+    cmdCache["hits"] = app.jsonproc.getCacheHits();
+    cmdCache["misses"] = app.jsonproc.getCacheMisses();
+
+    const PowerLimiter& power = app.rgbwwctrl.getPowerLimiter();
+    if (power.hasModel()) {
+        JsonObject pwr = data.createNestedObject("power");
+        pwr["current_ma"] = power.getCurrent();
+        pwr["power_mw"] = app.rgbwwctrl.getPowerMw();
+        pwr["budget_ma"] = app.cfg.power.budget_ma;
+        pwr["limited"] = power.isLimited();
+    }
+
+    const EnergyMeter& meter = app.rgbwwctrl.getEnergyMeter();
+    if (meter.isEnabled()) {
+        JsonObject energy = data.createNestedObject("energy");
+        energy["total_mwh"] = meter.getTotalEnergy();
+        JsonArray channels = energy.createNestedArray("mwh");
+        for (unsigned i=0; i < EnergyMeter::NumChannels; ++i)
+            channels.add(meter.getEnergy(i));
+    }
+
+    if (app.clockelection.isActive()) {
+        JsonObject election = data.createNestedObject("clock_election");
+        election["master"] = app.clockelection.isMaster();
+        election["master_id"] = app.clockelection.getMasterId();
+    }
+
     JsonObject con = data.createNestedObject("connection");
     con["connected"] = WifiStation.isConnected();
     con["ssid"] = WifiStation.getSSID();
@@ -670,7 +805,7 @@ void ApplicationWebserver::onColorGet(HttpRequest &request, HttpResponse &respon
     JsonObject json = stream->getRoot();
 
     JsonObject raw = json.createNestedObject("raw");
-    ChannelOutput output = app.rgbwwctrl.getCurrentOutput();
+    ChannelOutput output = app.rgbwwctrl.getCorrectedOutput();
     raw["r"] = output.r;
     raw["g"] = output.g;
     raw["b"] = output.b;
@@ -1085,3 +1220,149 @@ void ApplicationWebserver::onToggle(HttpRequest &request, HttpResponse &response
         sendApiCode(response, API_CODES::API_BAD_REQUEST);
     }
 }
+
+void ApplicationWebserver::onScene(HttpRequest &request, HttpResponse &response) {
+    if (request.method != HTTP_POST) {
+        sendApiCode(response, API_CODES::API_BAD_REQUEST, "not HTTP POST");
+        return;
+    }
+
+    String msg;
+    if (app.jsonproc.onScene(request.getBody(), msg)) {
+        sendApiCode(response, API_CODES::API_SUCCESS);
+    }
+    else {
+        sendApiCode(response, API_CODES::API_BAD_REQUEST, msg);
+    }
+}
+
+void ApplicationWebserver::onEffect(HttpRequest &request, HttpResponse &response) {
+    if (request.method != HTTP_POST) {
+        sendApiCode(response, API_CODES::API_BAD_REQUEST, "not HTTP POST");
+        return;
+    }
+
+    String msg;
+    if (app.jsonproc.onEffect(request.getBody(), msg)) {
+        sendApiCode(response, API_CODES::API_SUCCESS);
+    }
+    else {
+        sendApiCode(response, API_CODES::API_BAD_REQUEST, msg);
+    }
+}
+
+void ApplicationWebserver::onSequence(HttpRequest &request, HttpResponse &response) {
+    if (request.method != HTTP_POST) {
+        sendApiCode(response, API_CODES::API_BAD_REQUEST, "not HTTP POST");
+        return;
+    }
+
+    String msg;
+    if (app.jsonproc.onSequence(request.getBody(), msg)) {
+        sendApiCode(response, API_CODES::API_SUCCESS);
+    }
+    else {
+        sendApiCode(response, API_CODES::API_BAD_REQUEST, msg);
+    }
+}
+
+void ApplicationWebserver::onSequences(HttpRequest &request, HttpResponse &response) {
+    if (!authenticated(request, response)) {
+        return;
+    }
+
+#ifdef ARCH_ESP8266
+    if (app.ota.isProccessing()) {
+        sendApiCode(response, API_CODES::API_UPDATE_IN_PROGRESS);
+        return;
+    }
+#endif
+
+    if (request.method != HTTP_POST) {
+        sendApiCode(response, API_CODES::API_BAD_REQUEST, "not HTTP POST");
+        return;
+    }
+
+    String body = request.getBody();
+    if (body == NULL) {
+        sendApiCode(response, API_CODES::API_BAD_REQUEST, "could not get HTTP body");
+        return;
+    }
+
+    // with ?name=... the body is already compiled bytecode, otherwise JSON ops
+    String msg;
+    bool result;
+    String name = request.getQueryParameter("name");
+    if (name.length() > 0) {
+        result = SequencePlayer::store(name, body, msg);
+    }
+    else {
+        DynamicJsonDocument doc(2048);
+        Json::deserialize(doc, body);
+        result = app.jsonproc.onSequenceSave(doc.as<JsonObject>(), msg);
+    }
+
+    if (result) {
+        sendApiCode(response, API_CODES::API_SUCCESS);
+    }
+    else {
+        sendApiCode(response, API_CODES::API_BAD_REQUEST, msg);
+    }
+}
+
+void ApplicationWebserver::onScenes(HttpRequest &request, HttpResponse &response) {
+    if (!authenticated(request, response)) {
+        return;
+    }
+
+#ifdef ARCH_ESP8266
+    if (app.ota.isProccessing()) {
+        sendApiCode(response, API_CODES::API_UPDATE_IN_PROGRESS);
+        return;
+    }
+#endif
+
+    if (request.method != HTTP_POST && request.method != HTTP_GET) {
+        sendApiCode(response, API_CODES::API_BAD_REQUEST, "not HTTP POST or GET");
+        return;
+    }
+
+    if (request.method == HTTP_POST) {
+        String body = request.getBody();
+        if (body == NULL) {
+            sendApiCode(response, API_CODES::API_BAD_REQUEST, "could not get HTTP body");
+            return;
+        }
+
+        DynamicJsonDocument doc(1024);
+        Json::deserialize(doc, body);
+
+        String msg;
+        if (app.jsonproc.onSceneSave(doc.as<JsonObject>(), msg)) {
+            sendApiCode(response, API_CODES::API_SUCCESS);
+        }
+        else {
+            sendApiCode(response, API_CODES::API_BAD_REQUEST, msg);
+        }
+        return;
+    }
+
+    if (!checkHeap(response))
+        return;
+
+    JsonObjectStream* stream = new JsonObjectStream();
+    JsonObject json = stream->getRoot();
+    JsonArray list = json.createNestedArray("scenes");
+
+    Scene scene;
+    for (unsigned id=0; id < APP_SCENES_MAX; ++id) {
+        if (!app.rgbwwctrl.sceneStorage.load(id, scene))
+            continue;
+
+        JsonObject item = list.createNestedObject();
+        item["id"] = id;
+        item["name"] = String(scene.name, strnlen(scene.name, sizeof(scene.name)));
+        item["steps"] = scene.numSteps;
+    }
+    sendApiResponse(response, stream);
+}
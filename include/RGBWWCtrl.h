@@ -40,6 +40,9 @@
 #define DEFAULT_COLORTEMP_CW 6000
 
 #define PWM_FREQUENCY 339
+
+// uncomment to build the output stage for one color mode only (0: RGB, 1: RGBWW, 2: RGBCW, 3: RGBWWCW)
+//#define APP_FIXED_COLORMODE 1
 #define RGBWW_USE_ESP_HWPWM
 
 // Debugging
@@ -51,10 +54,27 @@
 #include <otaupdate.h>
 #endif
 #include <config.h>
+#include <scenes.h>
+#include <effects.h>
+#include <oklab.h>
+#include <transition.h>
+#include <sequence.h>
+#include <outputlut.h>
+#include <calibration.h>
+#include <ccttable.h>
+#include <powerlimit.h>
+#include <energymeter.h>
+#include <stagedoutput.h>
 #include <ledctrl.h>
 #include <networking.h>
 #include <webserver.h>
+#include <mqttpayload.h>
+#include <colorframe.h>
 #include <mqtt.h>
+#include <clockfilter.h>
+#include <clockudp.h>
+#include <clockelection.h>
+#include <ntptimeline.h>
 #include <eventserver.h>
 #include <jsonprocessor.h>
 #include <application.h>
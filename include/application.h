@@ -71,6 +71,9 @@ public:
     ApplicationSettings cfg;
     EventServer eventserver;
     AppMqttClient mqttclient;
+    ClockUdp clockudp;
+    ClockElection clockelection;
+    NtpTimeline ntptimeline;
     JsonProcessor jsonproc;
     NtpClient* pNtpclient = nullptr;
 
@@ -87,6 +90,7 @@ private:
     Timer _uptimetimer;
     uint32_t _uptimeMinutes;
     std::array<int, 17> _lastToggles;
+    std::array<int, 17> _buttonScenes; // scene recalled by a button, -1: toggle
 };
 // forward declaration for global vars
 extern Application app;
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <RGBWWLed/RGBWWLedColor.h>
+
+// Per device color calibration: a 3x3 matrix on red, green and blue and a
+// 2x2 matrix on the white channels, applied to the channel output before
+// the output tables. Coefficients are turned into Q12 integers once.
+class ColorCalibration {
+public:
+    static const int FracBits = 12;
+
+    // row major, rgb[0..2] is the row producing red
+    void build(const float rgb[9], const float white[4]);
+    bool isIdentity() const { return _identity; }
+
+    void apply(ChannelOutput& output) const {
+        const int32_t r = output.r;
+        const int32_t g = output.g;
+        const int32_t b = output.b;
+        output.r = clamp((_rgb[0] * r + _rgb[1] * g + _rgb[2] * b) >> FracBits);
+        output.g = clamp((_rgb[3] * r + _rgb[4] * g + _rgb[5] * b) >> FracBits);
+        output.b = clamp((_rgb[6] * r + _rgb[7] * g + _rgb[8] * b) >> FracBits);
+
+        const int32_t ww = output.ww;
+        const int32_t cw = output.cw;
+        output.ww = clamp((_white[0] * ww + _white[1] * cw) >> FracBits);
+        output.cw = clamp((_white[2] * ww + _white[3] * cw) >> FracBits);
+    }
+
+private:
+    static int32_t clamp(int32_t v) {
+        return (v < 0) ? 0 : ((v > RGBWW_CALC_MAXVAL) ? RGBWW_CALC_MAXVAL : v);
+    }
+
+    int32_t _rgb[9] = {};
+    int32_t _white[4] = {};
+    bool _identity = true;
+};
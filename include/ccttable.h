@@ -0,0 +1,35 @@
+#pragma once
+
+#include <RGBWWLed/RGBWWLedColor.h>
+
+// Warm/cold white mixing for a color temperature from a precomputed table.
+// The library still mixes the whites in its HSV conversion. The table is an
+// added lookup in the output stage that corrects that mix, not a
+// replacement for it. Entries are spaced evenly in mired, where mixing two white LEDs is close
+// to linear. The total white level is kept, so a ct fade does not change
+// the brightness. Outside the range of the white LEDs the red, green and
+// blue channels can assist with a tint.
+class CctTable {
+public:
+    static const int MiredMin = 100; // 10000K
+    static const int MiredMax = 500; // 2000K
+    static const int MiredStep = 4;
+    static const unsigned Size = (MiredMax - MiredMin) / MiredStep + 1;
+
+    // ww/cw: Kelvin of the white LEDs, rgbAssist: tint strength in percent
+    void build(int ww, int cw, int rgbAssist);
+    void setEnabled(bool enabled) { _enabled = enabled; }
+    bool isEnabled() const { return _enabled; }
+
+    // ct is mired (100..500) or Kelvin (2000..10000) like HSVCT, 0 keeps the output
+    void apply(int ct, ChannelOutput& output) const;
+
+private:
+    struct Entry {
+        uint16_t ww;      // share of the white level on warm white, Q12
+        uint16_t r, g, b; // RGB assist relative to the white level, Q12
+    };
+
+    Entry _table[Size];
+    bool _enabled = false;
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <RGBWWLed/RGBWWLedColor.h>
+
+// bit set of CtrlChannel values, an empty mask addresses all channels
+typedef uint16_t ChannelMask;
+
+constexpr ChannelMask channelBit(CtrlChannel channel) {
+    return static_cast<ChannelMask>(1u << static_cast<unsigned>(channel));
+}
+
+inline bool hasChannel(ChannelMask mask, CtrlChannel channel) {
+    return mask == 0 || (mask & channelBit(channel));
+}
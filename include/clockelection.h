@@ -0,0 +1,56 @@
+#pragma once
+
+#define APP_CLOCKELECTION_LEASE_MS 3500
+#define APP_CLOCKELECTION_CLAIM_MS 1500
+
+/*
+ * Elects the clock master among the devices sharing an election topic,
+ * replacing the fixed clock_master_enabled / clock_slave_enabled roles.
+ *
+ * The master publishes a heartbeat with its step counter every second, the
+ * heartbeat is also the master clock of the group. A follower that missed
+ * the heartbeats for a lease claims the role and takes it if no device with
+ * a lower id objected within the claim window. A master steps down for any
+ * lower id. A follower continues the timeline of the master it followed, so
+ * the other devices keep their phase over a failover.
+ *
+ * Messages: {"id": "<mqtt id>", "role": "master", "steps": n} and
+ * {"id": "<mqtt id>", "role": "claim"}. Lowest id (string compare) wins.
+ */
+class ClockElection {
+public:
+    enum class Role {
+        Follower,
+        Candidate,
+        Master,
+    };
+
+    void start(const String& id);
+    void stop();
+    bool isActive() const { return _active; }
+
+    // once per second from the LED step loop, heartbeats start on a step boundary
+    void onTick(uint32_t steps);
+    void onMessage(const String& message);
+
+    Role getRole() const { return _role; }
+    bool isMaster() const { return _active && _role == Role::Master; }
+    // a master is known and its heartbeats arrive
+    bool hasMaster() const;
+    const String& getMasterId() const { return _masterId; }
+
+private:
+    void claim();
+    void promote();
+    void follow(const String& id);
+    void onHeartbeat(const String& id, uint32_t steps);
+
+    bool _active = false;
+    Role _role = Role::Follower;
+    String _id;
+    String _masterId;
+    uint32_t _lastHeartbeatMs = 0;
+    uint32_t _claimMs = 0;
+    uint32_t _lastSyncMs = 0;
+    bool _synced = false;
+};
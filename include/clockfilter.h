@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+// Picks clock packets that arrived with close to the minimum network delay.
+// The delay is measured from the master send timestamp to the local receive
+// time; both clocks are unrelated, so only the delay relative to the minimum
+// of the last packets is meaningful.
+class ClockFilter {
+public:
+    static const unsigned WindowSize = 8;
+    // packets delayed more than this above the minimum are outliers
+    static const int32_t MaxExcessUs = 3000;
+
+    // returns true if the packet is usable for synchronization
+    bool onPacket(uint32_t sendUs, uint32_t recvUs);
+    void reset() { _count = 0; }
+
+    // delay above the window minimum of the last packet
+    int32_t getExcess() const { return _excess; }
+
+private:
+    uint32_t _base = 0;
+    int32_t _delays[WindowSize];
+    unsigned _count = 0;
+    unsigned _pos = 0;
+    int32_t _excess = 0;
+};
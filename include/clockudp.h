@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Network/UdpConnection.h>
+#include "clockfilter.h"
+
+#define APP_CLOCKUDP_RECEIVE_TIMEOUT_MS 5000
+
+/*
+ * Master clock over UDP multicast on the local network, avoiding the
+ * variable latency of the MQTT broker round trip.
+ *
+ * The master sends a packet every second: "RWC" + version, step counter,
+ * send timestamp in us and the time into the current step in us (u32
+ * little endian each). The time into the step lets slaves steer their phase
+ * finer than a whole step. Slaves pass only
+ * packets with close to minimum delay to the step sync, at most once per
+ * clock_master_interval. While no packets arrive, slaves fall back to the
+ * MQTT clock.
+ */
+class ClockUdp {
+public:
+    ~ClockUdp();
+
+    void start();
+    void stop();
+    void sendClock(uint32_t steps, uint32_t stepUs);
+
+    // usable clock packets received recently
+    bool isReceiving() const;
+
+private:
+    void onReceive(UdpConnection& connection, char* data, int size, IpAddress remoteIP, uint16_t remotePort);
+
+    static const uint8_t _version = 2;
+    static const int _packetSize = 16;
+
+    UdpConnection* _udp = nullptr;
+    IpAddress _group;
+    ClockFilter _filter;
+    bool _synced = false;
+    uint32_t _lastGoodMs = 0;
+    uint32_t _lastSyncMs = 0;
+};
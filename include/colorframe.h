@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+ * Fixed size binary color state for color master / slave mirroring, an
+ * alternative to the JSON color payload (sync.color_master_binary).
+ *
+ * Layout, little endian: "RWF" + version, mode, reserved, 5 x u16 values
+ * and the master step (u32). HSV frames carry h, s, v and ct in the
+ * internal units of HSVCT (no radians), raw frames r, g, b, ww, cw.
+ * Slaves tell it from JSON by size and magic.
+ */
+struct ColorFrame {
+    enum Mode : uint8_t {
+        Raw = 0,
+        Hsv = 1,
+    };
+
+    static const size_t Size = 20;
+    static const size_t NumValues = 5;
+
+    void encode(uint8_t* buffer) const;
+    bool decode(const uint8_t* buffer, size_t length);
+
+    uint8_t mode = Raw;
+    uint16_t values[NumValues] = {};
+    uint32_t step = 0;
+
+private:
+    static const uint8_t _version = 1;
+};
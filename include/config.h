@@ -27,7 +27,7 @@
 #define APP_SETTINGS_FILE ".cfg"
 #define APP_SETTINGS_VERSION 1
 
-#define CONFIG_MAX_LENGTH 2048
+#define CONFIG_MAX_LENGTH 4096
 
 
 struct ApplicationSettings {
@@ -67,12 +67,26 @@ struct ApplicationSettings {
         bool clock_slave_enabled = false;
         String clock_slave_topic= "home/led1/clock";
 
+        // clock over UDP multicast, MQTT stays the fallback
+        bool clock_udp_enabled = false;
+        String clock_udp_group = "239.255.82.87";
+        int clock_udp_port = 8287;
+
+        // devices on the election topic pick the clock master themselves, replaces the two settings above
+        bool clock_election_enabled = false;
+        String clock_election_topic = "home/rgbww/election";
+
         bool cmd_master_enabled = false;
+        int cmd_lead_ms = 0; // relayed commands start this much later, together on all devices
         bool cmd_slave_enabled = false;
         String cmd_slave_topic = "home/led1/command";
+        // comma separated group names, commands on <topic_base>group/<name>/command
+        String cmd_groups = "";
+        bool cmd_broadcast_enabled = false; // commands on <topic_base>broadcast/command
 
         bool color_master_enabled = false;
         int color_master_interval_ms = 0;
+        bool color_master_binary = false; // ColorFrame instead of JSON, slaves understand both
         bool color_slave_enabled = false;
         String color_slave_topic = "home/led1/color";
     };
@@ -88,6 +102,25 @@ struct ApplicationSettings {
         bool enabled = false;
         String server;
         int interval;
+        // LED step counter follows NTP time, a shared timeline without clock master
+        bool step_sync = false;
+        int step_interval = 60;
+    };
+
+    struct power {
+        // supply current per channel at full duty in mA, 0 = not modeled
+        int red_ma = 0;
+        int green_ma = 0;
+        int blue_ma = 0;
+        int ww_ma = 0;
+        int cw_ma = 0;
+        int budget_ma = 0;      // 0 = no limit
+        int voltage_mv = 12000; // for power telemetry and energy metering
+    };
+
+    struct energy {
+        int save_interval_min = 60; // bounds flash writes of the counters
+        int publish_interval_s = 60;
     };
 
     struct color {
@@ -112,11 +145,34 @@ struct ApplicationSettings {
         struct colortemp {
             int ww = DEFAULT_COLORTEMP_WW;
             int cw = DEFAULT_COLORTEMP_CW;
+            bool table = false;  // mix ww/cw from the precomputed table (RGBWWCW only)
+            int rgb_assist = 0;  // percent of RGB tint outside the white range
+        };
+
+        struct dimming {
+            String curve = "linear"; // linear, cie1931 or gamma
+            int gamma = 220;         // gamma * 100
+        };
+
+        struct dithering {
+            bool red = false;
+            bool green = false;
+            bool blue = false;
+            bool ww = false;
+            bool cw = false;
+        };
+
+        struct calibration {
+            float rgb[9] = { 1, 0, 0,  0, 1, 0,  0, 0, 1 }; // row major, row 0 produces red
+            float white[4] = { 1, 0,  0, 1 };               // row 0 produces ww, row 1 cw
         };
 
         hsv hsv;
         brightness brightness;
         colortemp colortemp;
+        dimming dimming;
+        dithering dithering;
+        calibration calibration;
         int outputmode = 0;
         String startup_color = "last";
     };
@@ -137,6 +193,8 @@ struct ApplicationSettings {
     sync sync;
     events events;
     ntp ntp;
+    power power;
+    energy energy;
 
     void load(bool print = false) {
         // 1024 is too small and leads to load error
@@ -193,6 +251,39 @@ struct ApplicationSettings {
             color.brightness.ww = jbri["ww"];
             color.brightness.cw = jbri["cw"];
 
+            // colortemp
+            JsonObject jct = jcol["colortemp"];
+            Json::getValue(jct["ww"], color.colortemp.ww);
+            Json::getValue(jct["cw"], color.colortemp.cw);
+            Json::getValue(jct["table"], color.colortemp.table);
+            Json::getValue(jct["rgb_assist"], color.colortemp.rgb_assist);
+
+            // dimming
+            JsonObject jdim = jcol["dimming"];
+            Json::getValue(jdim["curve"], color.dimming.curve);
+            Json::getValue(jdim["gamma"], color.dimming.gamma);
+
+            // dithering
+            JsonObject jdit = jcol["dithering"];
+            Json::getValue(jdit["red"], color.dithering.red);
+            Json::getValue(jdit["green"], color.dithering.green);
+            Json::getValue(jdit["blue"], color.dithering.blue);
+            Json::getValue(jdit["ww"], color.dithering.ww);
+            Json::getValue(jdit["cw"], color.dithering.cw);
+
+            // calibration
+            JsonObject jcal = jcol["calibration"];
+            JsonArray jrgb = jcal["rgb"];
+            if (jrgb.size() == 9) {
+                for (unsigned i=0; i < 9; ++i)
+                    color.calibration.rgb[i] = jrgb[i];
+            }
+            JsonArray jwhite = jcal["white"];
+            if (jwhite.size() == 4) {
+                for (unsigned i=0; i < 4; ++i)
+                    color.calibration.white[i] = jwhite[i];
+            }
+
             // general
             auto jgen = root["general"];
             if (!jgen.isNull()) {
@@ -208,9 +299,11 @@ struct ApplicationSettings {
             // ntp
             auto jntp = root["ntp"];
             if (!jntp.isNull()) {
-                Json::getValue(jgen["enabled"], ntp.enabled);
-                Json::getValue(jgen["server"], ntp.server);
-                Json::getValue(jgen["interval"], ntp.interval);
+                Json::getValue(jntp["enabled"], ntp.enabled);
+                Json::getValue(jntp["server"], ntp.server);
+                Json::getValue(jntp["interval"], ntp.interval);
+                Json::getValue(jntp["step_sync"], ntp.step_sync);
+                Json::getValue(jntp["step_interval"], ntp.step_interval);
             }
 
             // sync
@@ -220,18 +313,46 @@ struct ApplicationSettings {
                 Json::getValue(jsync["clock_master_interval"], sync.clock_master_interval);
                 Json::getValue(jsync["clock_slave_topic"], sync.clock_slave_topic);
                 Json::getValue(jsync["clock_slave_enabled"], sync.clock_slave_enabled);
+                Json::getValue(jsync["clock_udp_enabled"], sync.clock_udp_enabled);
+                Json::getValue(jsync["clock_udp_group"], sync.clock_udp_group);
+                Json::getValue(jsync["clock_udp_port"], sync.clock_udp_port);
+                Json::getValue(jsync["clock_election_enabled"], sync.clock_election_enabled);
+                Json::getValue(jsync["clock_election_topic"], sync.clock_election_topic);
 
                 Json::getValue(jsync["cmd_master_enabled"], sync.cmd_master_enabled);
+                Json::getValue(jsync["cmd_lead_ms"], sync.cmd_lead_ms);
                 Json::getValue(jsync["cmd_slave_enabled"], sync.cmd_slave_enabled);
                 Json::getValue(jsync["cmd_slave_topic"], sync.cmd_slave_topic);
+                Json::getValue(jsync["cmd_groups"], sync.cmd_groups);
+                Json::getValue(jsync["cmd_broadcast_enabled"], sync.cmd_broadcast_enabled);
 
                 Json::getValue(jsync["color_master_enabled"], sync.color_master_enabled);
                 Json::getValue(jsync["color_master_interval_ms"], sync.color_master_interval_ms);
+                Json::getValue(jsync["color_master_binary"], sync.color_master_binary);
                 Json::getValue(jsync["color_slave_enabled"], sync.color_slave_enabled);
                 Json::getValue(jsync["color_slave_topic"], sync.color_slave_topic);
             }
 
 
+            // power
+            auto jpower = root["power"];
+            if (!jpower.isNull()) {
+                Json::getValue(jpower["red_ma"], power.red_ma);
+                Json::getValue(jpower["green_ma"], power.green_ma);
+                Json::getValue(jpower["blue_ma"], power.blue_ma);
+                Json::getValue(jpower["ww_ma"], power.ww_ma);
+                Json::getValue(jpower["cw_ma"], power.cw_ma);
+                Json::getValue(jpower["budget_ma"], power.budget_ma);
+                Json::getValue(jpower["voltage_mv"], power.voltage_mv);
+            }
+
+            // energy
+            auto jenergy = root["energy"];
+            if (!jenergy.isNull()) {
+                Json::getValue(jenergy["save_interval_min"], energy.save_interval_min);
+                Json::getValue(jenergy["publish_interval_s"], energy.publish_interval_s);
+            }
+
             // events
             auto jevents = root["events"];
             if (!jevents.isNull()) {
@@ -300,27 +421,72 @@ struct ApplicationSettings {
         JsonObject t = c.createNestedObject("colortemp");
         t["ww"] = color.colortemp.ww;
         t["cw"] = color.colortemp.cw;
+        t["table"] = color.colortemp.table;
+        t["rgb_assist"] = color.colortemp.rgb_assist;
+
+        JsonObject d = c.createNestedObject("dimming");
+        d["curve"] = color.dimming.curve.c_str();
+        d["gamma"] = color.dimming.gamma;
+
+        JsonObject dit = c.createNestedObject("dithering");
+        dit["red"] = color.dithering.red;
+        dit["green"] = color.dithering.green;
+        dit["blue"] = color.dithering.blue;
+        dit["ww"] = color.dithering.ww;
+        dit["cw"] = color.dithering.cw;
+
+        JsonObject cal = c.createNestedObject("calibration");
+        JsonArray calRgb = cal.createNestedArray("rgb");
+        for (float v : color.calibration.rgb)
+            calRgb.add(v);
+        JsonArray calWhite = cal.createNestedArray("white");
+        for (float v : color.calibration.white)
+            calWhite.add(v);
 
         JsonObject n = root.createNestedObject("ntp");
         n["enabled"] = ntp.enabled;
         n["server"] = ntp.server;
         n["interval"] = ntp.interval;
+        n["step_sync"] = ntp.step_sync;
+        n["step_interval"] = ntp.step_interval;
 
         JsonObject s = root.createNestedObject("sync");
         s["clock_master_enabled"] = sync.clock_master_enabled;
         s["clock_master_interval"] = sync.clock_master_interval;
         s["clock_slave_enabled"] = sync.clock_slave_enabled;
         s["clock_slave_topic"] = sync.clock_slave_topic.c_str();
+        s["clock_udp_enabled"] = sync.clock_udp_enabled;
+        s["clock_udp_group"] = sync.clock_udp_group.c_str();
+        s["clock_udp_port"] = sync.clock_udp_port;
+        s["clock_election_enabled"] = sync.clock_election_enabled;
+        s["clock_election_topic"] = sync.clock_election_topic.c_str();
 
         s["cmd_master_enabled"] = sync.cmd_master_enabled;
+        s["cmd_lead_ms"] = sync.cmd_lead_ms;
         s["cmd_slave_enabled"] = sync.cmd_slave_enabled;
         s["cmd_slave_topic"] = sync.cmd_slave_topic.c_str();
+        s["cmd_groups"] = sync.cmd_groups.c_str();
+        s["cmd_broadcast_enabled"] = sync.cmd_broadcast_enabled;
 
         s["color_master_enabled"] = sync.color_master_enabled;
         s["color_master_interval_ms"] = sync.color_master_interval_ms;
+        s["color_master_binary"] = sync.color_master_binary;
         s["color_slave_enabled"] = sync.color_slave_enabled;
         s["color_slave_topic"] = sync.color_slave_topic.c_str();
 
+        JsonObject p = root.createNestedObject("power");
+        p["red_ma"] = power.red_ma;
+        p["green_ma"] = power.green_ma;
+        p["blue_ma"] = power.blue_ma;
+        p["ww_ma"] = power.ww_ma;
+        p["cw_ma"] = power.cw_ma;
+        p["budget_ma"] = power.budget_ma;
+        p["voltage_mv"] = power.voltage_mv;
+
+        JsonObject en = root.createNestedObject("energy");
+        en["save_interval_min"] = energy.save_interval_min;
+        en["publish_interval_s"] = energy.publish_interval_s;
+
         JsonObject e = root.createNestedObject("events");
         e["color_interval_ms"] = events.color_interval_ms;
         e["server_enabled"] = events.server_enabled;
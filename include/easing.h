@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+class String;
+
+// Easing curves for fades. Progress and result are fixed-point 0..65535.
+namespace Easing {
+    enum Curve : uint8_t {
+        Linear = 0,
+        In = 1,    // quadratic, slow start
+        Out = 2,   // quadratic, slow end
+        InOut = 3, // smoothstep
+        Cie = 4,   // CIE L*, perceptually even brightness change
+        Exp = 5,   // exponential
+        NumCurves,
+    };
+
+    // 64 segments per curve, index 0 is In
+    extern const uint16_t tables[NumCurves - 1][65];
+
+    inline uint16_t apply(uint8_t curve, uint16_t p) {
+        if (curve == Linear || curve >= NumCurves)
+            return p;
+
+        const uint16_t* table = tables[curve - 1];
+        const unsigned idx = p >> 10;
+        const int32_t a = table[idx];
+        return a + (((table[idx + 1] - a) * static_cast<int32_t>(p & 0x3ff)) >> 10);
+    }
+
+    // NumCurves if the name is unknown
+    Curve fromName(const String& name);
+}
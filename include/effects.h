@@ -0,0 +1,50 @@
+#pragma once
+
+#include <RGBWWLed/RGBWWLedColor.h>
+#include "channelmask.h"
+
+// Procedural effects computed per LED tick in fixed-point. An effect is an
+// overlay on the current color: it does not touch the animation queue and
+// only modifies the channels it is scoped to.
+class EffectEngine {
+public:
+    enum class Effect : uint8_t {
+        None,
+        Rainbow, // hue rotation
+        Breathe, // sine modulation of the level
+        Candle,  // smoothed value noise on the level
+        Strobe,  // on/off flashes
+    };
+
+    struct Params {
+        Effect effect = Effect::None;
+        uint32_t period = 5000; // ms per cycle (flicker interval for candle)
+        uint16_t min = 0;       // lowest level as fraction of 65535
+        uint16_t max = 65535;   // highest level as fraction of 65535
+        uint16_t duty = 6554;   // strobe on time as fraction of the period
+        ChannelMask channels = 0; // empty: hue for rainbow, value otherwise
+    };
+
+    void start(const Params& params);
+    void stop();
+    bool isActive() const { return _params.effect != Effect::None; }
+    const Params& getParams() const { return _params; }
+
+    // step is the LED step counter, so synchronized controllers run in phase
+    void apply(uint32_t step, HSVCT& color) const;
+    void apply(uint32_t step, ChannelOutput& output) const;
+
+    static Effect fromName(const String& name);
+    static const char* toName(Effect effect);
+
+private:
+    uint16_t waveform(uint32_t step) const;
+    uint16_t level(uint16_t wave) const;
+
+    static int32_t sine(uint16_t phase);
+    static uint16_t noise(uint32_t x);
+
+    Params _params;
+    // period in LED steps, the phase comes from the step counter so it does not jump when ms would wrap
+    uint32_t _periodSteps = 1;
+};
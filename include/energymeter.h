@@ -0,0 +1,45 @@
+#pragma once
+
+#include <RGBWWLed/RGBWWLedColor.h>
+
+#define APP_ENERGY_FILE ".energy"
+
+// Energy counters integrated from the PWM duty of each channel. Each LED
+// step only adds the duty to a per channel accumulator, update() folds the
+// accumulators into mWh counters about once per second.
+class EnergyMeter {
+public:
+    static const unsigned NumChannels = 5;
+
+    // power per channel at full duty in mW (0: not metered), stepMs: length of one LED step
+    void configure(const uint32_t powerMw[NumChannels], uint32_t stepMs);
+    bool isEnabled() const { return _enabled; }
+
+    void add(const ChannelOutput& output) {
+        _duty[0] += output.r;
+        _duty[1] += output.g;
+        _duty[2] += output.b;
+        _duty[3] += output.ww;
+        _duty[4] += output.cw;
+    }
+
+    // returns true if a counter changed
+    bool update();
+
+    uint32_t getEnergy(unsigned channel) const { return _mwh[channel]; }
+    uint32_t getTotalEnergy() const;
+
+    void load();
+    void save();
+    void reset();
+
+private:
+    uint32_t _powerMw[NumChannels] = {};
+    uint32_t _stepMs = 0;
+    bool _enabled = false;
+
+    uint32_t _duty[NumChannels] = {};
+    // mW * ms * duty below one mWh
+    uint64_t _rest[NumChannels] = {};
+    uint32_t _mwh[NumChannels] = {};
+};
@@ -13,7 +13,8 @@ public:
 	void publishCurrentState(const ChannelOutput& raw, const HSVCT* pColor = NULL);
 	void publishTransitionFinished(const String& name, bool requeued = false);
 	void publishKeepAlive();
-	void publishClockSlaveStatus(int offset, uint32_t interval);
+	void publishClockSlaveStatus(int offset, uint32_t interval, int driftPpm, bool locked);
+	void publishPowerStatus(uint32_t currentMa, uint32_t powerMw, bool limited);
 
 private:
 	virtual void onClient(TcpClient *client) override;
@@ -1,7 +1,15 @@
 #pragma once
 
 #include <RGBWWLed/RGBWWLedColor.h>
+#include "channelmask.h"
+#include "easing.h"
 
+// number of parsed color commands kept for repeated payloads
+#define APP_PARAMS_CACHE_SIZE 8
+
+// commands waiting for their master step ("at")
+#define APP_SCHEDULED_MAX 8
+#define APP_SCHEDULED_HORIZON_STEPS (60 * RGBWW_UPDATEFREQUENCY)
 
 class JsonProcessor {
 public:
@@ -29,10 +37,26 @@ public:
     bool onDirect(const String& json, String& msg, bool relay);
     bool onDirect(JsonObject root, String& msg, bool relay);
 
+    bool onEffect(const String& json, String& msg, bool relay = true);
+    bool onEffect(JsonObject root, String& msg, bool relay = true);
+
+    bool onScene(const String& json, String& msg, bool relay = true);
+    bool onScene(JsonObject root, String& msg, bool relay = true);
+    bool onSceneSave(JsonObject root, String& msg);
+
+    bool onSequence(const String& json, String& msg, bool relay = true);
+    bool onSequence(JsonObject root, String& msg, bool relay = true);
+    bool onSequenceSave(JsonObject root, String& msg);
+
     bool onJsonRpc(const String& json);
 
-private:
+    // run the scheduled commands which are due in this LED step
+    void onStep(uint32_t step);
 
+    uint32_t getCacheHits() const { return _paramsCache.getHits(); }
+    uint32_t getCacheMisses() const { return _paramsCache.getMisses(); }
+
+private:
     struct RequestParameters {
         String target;
 
@@ -61,15 +85,72 @@ private:
 
         String cmd = "solid";
 
-        RGBWWLed::ChannelList channels;
+        ChannelMask channels = 0;
 
         QueuePolicy queue = QueuePolicy::Single;
 
+        uint8_t ease = Easing::Linear;
+        bool relative = false;
+
         int checkParams(String& errorMsg) const;
+
+        // computed by the app instead of the RGBWWLed animation queue
+        bool isTransition() const { return ease != Easing::Linear || cmd == "fade_oklab"; }
     };
 
     void parseRequestParams(JsonObject root, RequestParameters& params);
-    void addChannelStatesToCmd(JsonObject root, const RGBWWLed::ChannelList& channels);
+    static ChannelMask parseChannels(JsonVariant var);
+    static bool hasRelativeValues(JsonObject color);
+    void addChannelStatesToCmd(JsonObject root, ChannelMask channels);
+    const RGBWWLed::ChannelList& toChannelList(ChannelMask channels);
+
+    bool dispatch(const String& method, JsonObject params);
+    bool deferCommand(const String& method, JsonObject root, bool relay);
 
     bool onSingleColorCommand(JsonObject root, String& errorMsg);
+    bool queueColorCommand(const RequestParameters& params, String& errorMsg);
+    void startTransition(const RequestParameters& params);
+    bool toSceneStep(JsonObject root, SceneStep& step, String& errorMsg);
+    bool compileSequence(JsonArray ops, String& program, String& errorMsg);
+
+    // LRU cache of validated color commands keyed by their raw payload.
+    // Hits and misses count cacheable commands only: get() counts the hits, put() the misses.
+    class ParamsCache {
+    public:
+        const RequestParameters* get(const String& payload);
+        void put(const String& payload, const RequestParameters& params);
+
+        uint32_t getHits() const { return _hits; }
+        uint32_t getMisses() const { return _misses; }
+
+    private:
+        struct Entry {
+            uint32_t hash = 0;
+            uint32_t lastUse = 0;
+            String payload;
+            RequestParameters params;
+        };
+
+        static uint32_t hash(const String& payload);
+
+        Entry _entries[APP_PARAMS_CACHE_SIZE];
+        uint32_t _useCounter = 0;
+        uint32_t _hits = 0;
+        uint32_t _misses = 0;
+    };
+
+    ParamsCache _paramsCache;
+
+    struct ScheduledCommand {
+        uint32_t due; // local step
+        String method;
+        String params;
+    };
+
+    // ordered by due step
+    Vector<ScheduledCommand> _scheduled;
+
+    // last list handed to RGBWWLed, rebuilt only when the mask changes
+    RGBWWLed::ChannelList _channelList;
+    ChannelMask _channelListMask = 0;
 };
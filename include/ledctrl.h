@@ -26,6 +26,12 @@
 
 #define APP_COLOR_FILE ".color"
 
+// larger NTP corrections move the step counter instead of steering towards it
+#define APP_WALLCLOCK_MAXSTEER_STEPS 50
+
+// color frames up to this much older than the last applied one arrived late
+#define APP_COLORFRAME_MAXAGE_STEPS (10 * RGBWW_UPDATEFREQUENCY)
+
 struct PinConfig {
     PinConfig() : red(13), green(12), blue(14), warmwhite(5), coldwhite(4) {}
 
@@ -85,11 +91,48 @@ public:
     void colorReset();
     void testChannels();
     void toggle();
+    bool recallScene(uint8_t id);
+
+    void startEffect(const EffectEngine::Params& params);
+    void stopEffect();
+    const EffectEngine& getEffect() const { return _effects; }
+
+    void fadeEased(const HSVCT& to, uint32_t ms, uint8_t ease, ChannelMask channels, int direction, const String& name = "");
+    void fadeEased(const ChannelOutput& to, uint32_t ms, uint8_t ease, ChannelMask channels, const String& name = "");
+    void fadeOklab(const HSVCT& to, uint32_t ms, uint8_t ease, const String& name = "");
+    void fadeOklab(const ChannelOutput& to, uint32_t ms, uint8_t ease, const String& name = "");
+    void stopTransition();
+
+    bool startSequence(const String& name);
+    void stopSequence();
+    const SequencePlayer& getSequence() const { return _sequence; }
+
+    const PowerLimiter& getPowerLimiter() const { return _powerLimiter; }
+    uint32_t getPowerMw() const;
+    const EnergyMeter& getEnergyMeter() const { return _energyMeter; }
+    void saveEnergy();
+    void saveClockDrift();
+    void resetEnergy();
 
     void updateLed();
+    // current output with the brightness correction, as reported to clients and slaves
+    ChannelOutput getCorrectedOutput() const;
+    uint32_t getStepCounter() const { return _stepCounter; }
+    bool toLocalSteps(uint32_t masterSteps, uint32_t& steps) const;
+    bool toMasterSteps(uint32_t steps, uint32_t& masterSteps) const;
+    bool isClockMaster() const;
+    bool isClockSlave() const;
+    void continueTimeline();
     void onMasterClock(uint32_t steps);
+    // with the time into the master's step and the local receive time, for sub-step phase
+    void onMasterClock(uint32_t steps, uint32_t masterStepUs, uint32_t recvUs);
+    void onWallClock(uint32_t steps, uint32_t usToNextStep);
     void onMasterClockReset();
+    void onColorFrame(const ColorFrame& frame);
     virtual void onAnimationFinished(const String& name, bool requeued);
+
+    SceneStorage sceneStorage;
+
 private:
     static PinConfig parsePinConfigString(String& pinStr);
     static void updateLedCb(void* pTimerArg);
@@ -99,6 +142,13 @@ private:
     void publishColorStayedCmds();
     void checkStableColorState();
     void publishStatus();
+    void publishPower();
+    void updateEnergy();
+    void applyEffect();
+    void writeOutput(ChannelOutput output);
+    ChannelOutput mixColorTemp(const HSVCT& color, ChannelOutput output) const;
+    void prepareTransition(const String& name);
+    void steerToMaster(uint32_t stepsMaster, int32_t subStepUs);
 
     ColorStorage colorStorage;
 
@@ -106,8 +156,25 @@ private:
     ChannelOutput _lastOutput;
 
     StepSync* _stepSync = nullptr;
+    StagedPWMOutput* _stagedOutput = nullptr;
+    EffectEngine _effects;
+    SequencePlayer _sequence;
+    Transition _transition;
+    String _transitionName;
+    OutputLut _outputLut;
+    ColorCalibration _calibration;
+    CctTable _cctTable;
+    PowerLimiter _powerLimiter;
+    uint32_t _lastPublishedCurrent = 0;
+    EnergyMeter _energyMeter;
+    uint32_t _energySeconds = 0;
+    uint32_t _energySavedAt = 0;
+    bool _energyDirty = false;
+    OutputLut::Kernel _outputKernel = nullptr;
 
     uint32_t _stepCounter = 0;
+    // micros() when the running step started
+    uint32_t _stepStartUs = 0;
     HSVCT _prevColor;
     uint32_t _numStableColorSteps = 0;
     ChannelOutput _prevOutput;
@@ -115,7 +182,11 @@ private:
     static const uint32_t _saveAfterStableColorMs = 2000;
 
     SimpleTimer _ledTimer;
+    bool _wallClockAligned = false;
+    bool _restoreInterval = false;
     uint32_t _timerInterval = RGBWW_MINTIMEDIFF;
     HashMap<String, bool> _stepFinishedAnimations;
     uint32_t _lastColorEvent = 0;
+    bool _hasColorFrame = false;
+    uint32_t _colorFrameStep = 0;
 };
@@ -1,6 +1,16 @@
 #pragma once
 
 #include "RGBWWCtrl.h"
+#include "mqttpayload.h"
+#include "colorframe.h"
+
+#define APP_MQTT_QUEUE_MAX 16
+#define APP_MQTT_QUEUE_BYTES 2048
+// queued commands and notifications older than this are not replayed
+#define APP_MQTT_QUEUE_MAX_AGE_MS 60000
+#define APP_MQTT_RECONNECT_MIN_MS 1000
+#define APP_MQTT_RECONNECT_MAX_MS 60000
+#define APP_MQTT_GROUPS_MAX 8
 
 class IMasterClockSink;
 
@@ -22,15 +32,59 @@ public:
     void publishClockReset();
     void publishClockInterval(uint32_t curInterval);
     void publishClockSlaveOffset(int offset);
+    void publishClockSlaveStatus(int offset, int driftPpm, bool locked);
     void publishCommand(const String& method, const JsonObject& params);
     void publishTransitionFinished(const String& name, bool requeued);
+    void publishPowerStatus(uint32_t currentMa, uint32_t powerMw, bool limited);
+    void publishEnergy(const EnergyMeter& meter);
+    void publishElection(const char* role, uint32_t steps = 0);
+
+    const String& getId() const { return _id; }
 
 private:
+    // what happens to a message published while the broker is not connected
+    enum class QueuePolicy {
+        Drop,       // only valid right now, like the clock
+        Latest,     // state, a newer message on the same topic replaces it
+        Fifo,       // events, all are sent in order after reconnecting
+    };
+
+    struct QueuedMessage {
+        String topic;
+        String data;
+        bool retain;
+        QueuePolicy policy;
+        uint32_t queuedMs;
+    };
+
+    typedef void (AppMqttClient::*RouteHandler)(const char* payload, size_t length);
+
+    // subscribed topic, hashed once at connect() so a message costs one hash and no String
+    struct Route {
+        uint32_t hash;
+        String topic;
+        RouteHandler handler;
+    };
+
+    static uint32_t hashTopic(const char* topic, size_t length);
+
     void connectDelayed(int delay = 2000);
     void connect();
     void onComplete(TcpClient& client, bool success);
-    void onMessageReceived(String topic, String message);
-    void publish(const String& topic, const String& data, bool retain);
+    int onConnected(MqttClient& client, mqtt_message_t* message);
+    int onMessageReceived(MqttClient& client, mqtt_message_t* message);
+    void addRoute(const String& topic, RouteHandler handler);
+    void addGroupRoutes();
+    void onClockMessage(const char* payload, size_t length);
+    void onElectionMessage(const char* payload, size_t length);
+    void onCommandMessage(const char* payload, size_t length);
+    void onColorMessage(const char* payload, size_t length);
+    void publish(const String& topic, const String& data, bool retain, QueuePolicy policy = QueuePolicy::Drop);
+    void publish(const String& topic, const MqttPayload& payload, bool retain, QueuePolicy policy = QueuePolicy::Drop);
+    void publishColorFrame(ColorFrame& frame);
+    void enqueue(const String& topic, const String& data, bool retain, QueuePolicy policy);
+    void dropQueued(unsigned index);
+    void flushQueue();
 
     String buildTopic(const String& suffix);
 
@@ -39,6 +93,18 @@ private:
     Timer _procTimer;
     String _id;
     bool _firstClock = true;
+    Vector<Route> _routes;
+    Vector<QueuedMessage> _queue;
+    size_t _queueBytes = 0;
+    uint32_t _reconnectDelayMs = APP_MQTT_RECONNECT_MIN_MS;
+
+    // built once at init for the publishes at LED step rate
+    String _topicColor;
+    String _topicClock;
+    String _topicClockInterval;
+    String _topicClockSlaveOffset;
+    MqttPayload _payload;
+    String _payloadString;
 
     HSVCT _lastHsv;
     ChannelOutput _lastRaw;
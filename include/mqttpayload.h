@@ -0,0 +1,36 @@
+#pragma once
+
+/*
+ * Fixed buffer for the MQTT payloads published at the LED step rate.
+ *
+ * Formats the same JSON as the ArduinoJson documents did, without a
+ * document or any heap allocation. Text beyond the capacity is dropped
+ * and marks the payload as overflowed.
+ */
+class MqttPayload {
+public:
+    static const size_t Capacity = 128;
+
+    void clear();
+    MqttPayload& add(const char* text);
+    MqttPayload& add(uint32_t value);
+    MqttPayload& add(int value);
+    // fixed point, no exponent
+    MqttPayload& add(float value, unsigned decimals);
+
+    void setHsv(float h, float s, float v, int ct);
+    void setRaw(int r, int g, int b, int cw, int ww);
+    void setUint(uint32_t value);
+    void setInt(int value);
+
+    const char* c_str() const { return _buffer; }
+    size_t length() const { return _length; }
+    bool isOverflowed() const { return _overflow; }
+
+private:
+    void append(const char* text, size_t length);
+
+    char _buffer[Capacity + 1] = {};
+    size_t _length = 0;
+    bool _overflow = false;
+};
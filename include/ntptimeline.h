@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Network/UdpConnection.h>
+
+#define APP_NTP_PORT 123
+
+/*
+ * Shared LED step timeline derived from NTP time: step = wall time in us /
+ * RGBWW_MINTIMEDIFF_US. All devices with this mode run the same step
+ * counter without a clock master.
+ *
+ * Sming's NtpClient only reports whole seconds, so this sends its own SNTP
+ * requests and keeps the fraction. The first sample aligns the step counter
+ * and the phase of the LED timer, later samples steer it like a master clock.
+ */
+class NtpTimeline {
+public:
+    ~NtpTimeline();
+
+    void start(const String& server, unsigned intervalS);
+    void stop();
+    bool isActive() const { return _udp != nullptr; }
+
+private:
+    void query();
+    void send(IpAddress server);
+    void onReceive(UdpConnection& connection, char* data, int size, IpAddress remoteIP, uint16_t remotePort);
+    static void onDnsFound(const char* name, LWIP_IP_ADDR_T* ip, void* arg);
+
+    static const int _packetSize = 48;
+    // requests taking longer are not usable, the reply time is unknown within the round trip
+    static const uint32_t _maxRoundTripUs = 200000;
+
+    UdpConnection* _udp = nullptr;
+    Timer _timer;
+    String _server;
+    uint32_t _sentUs = 0;
+    bool _waiting = false;
+    uint32_t _bestRoundTripUs = _maxRoundTripUs;
+};
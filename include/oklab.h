@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+// Oklab perceptual color space for linear RGB (PWM duty is linear light).
+// L, a and b are fixed-point with 15 fraction bits, rgb is 0..RGBWW_CALC_MAXVAL.
+namespace Oklab {
+    struct Lab {
+        int32_t L = 0;
+        int32_t a = 0;
+        int32_t b = 0;
+    };
+
+    // needs a cube root, meant for the endpoints of a fade only
+    Lab fromRgb(int r, int g, int b);
+
+    // fixed-point only, cheap enough for every LED step
+    void toRgb(const Lab& lab, int& r, int& g, int& b);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <RGBWWLed/RGBWWLedColor.h>
+
+// Per channel output tables which fold the brightness correction and the
+// dimming curve into one interpolated lookup. Table values are PWM values
+// with OutputLut::FracBits additional fraction bits.
+class OutputLut {
+public:
+    enum class Curve : uint8_t {
+        Linear,
+        Cie1931, // perceptually uniform lightness
+        Gamma,
+    };
+
+    static const unsigned NumChannels = 5;
+    static const unsigned Size = 256;
+    static const unsigned FracBits = 4;
+
+    // brightness in percent per channel (r, g, b, ww, cw), gamma * 100
+    void build(const int brightness[NumChannels], Curve curve, int gamma);
+    bool isIdentity() const { return _identity && _ditherMask == 0; }
+
+    // bit n set: channel n is dithered over time with the table fraction
+    void setDithering(uint8_t mask);
+
+    // brightness correction alone, in RGBWWLed units like the library applied it.
+    // Used for the output reported to clients and slaves, not for the PWM.
+    void correct(ChannelOutput& output) const {
+        output.r = (output.r * _brightness[0]) >> 16;
+        output.g = (output.g * _brightness[1]) >> 16;
+        output.b = (output.b * _brightness[2]) >> 16;
+        output.ww = (output.ww * _brightness[3]) >> 16;
+        output.cw = (output.cw * _brightness[4]) >> 16;
+    }
+
+    // value 0..RGBWW_CALC_MAXVAL, result has FracBits fraction bits
+    uint32_t lookup(unsigned channel, int value) const {
+        uint32_t pos = static_cast<uint32_t>(value) * _step;
+        if (pos > (Size << 16))
+            pos = Size << 16;
+
+        const uint16_t* table = _tables[channel];
+        const unsigned idx = pos >> 16;
+        const uint32_t a = table[idx];
+        if (idx >= Size)
+            return a;
+        const int32_t frac = (pos >> 8) & 0xff;
+        return a + (((static_cast<int32_t>(table[idx + 1]) - static_cast<int32_t>(a)) * frac) >> 8);
+    }
+
+    // output stage specialized per color mode, white channels the mode does not use are passed through
+    typedef void (*Kernel)(OutputLut& lut, ChannelOutput& output);
+    static Kernel kernelFor(int colorMode);
+
+    template<RGBWW_COLORMODE Mode>
+    static void applyKernel(OutputLut& lut, ChannelOutput& output) {
+        output.r = lut.quantize(0, output.r);
+        output.g = lut.quantize(1, output.g);
+        output.b = lut.quantize(2, output.b);
+        if (Mode == RGBWW || Mode == RGBWWCW)
+            output.ww = lut.quantize(3, output.ww);
+        if (Mode == RGBCW || Mode == RGBWWCW)
+            output.cw = lut.quantize(4, output.cw);
+    }
+
+    // table lookup reduced to a PWM value. Dithered channels carry the
+    // dropped fraction over to the next step, so on average the output
+    // keeps the full table resolution. The price is a one step pattern
+    // that repeats after up to 2^FracBits steps, at 50 Hz down to ~3 Hz,
+    // which can be visible as flicker on the dimmest levels.
+    int quantize(unsigned channel, int value) {
+        uint32_t v = lookup(channel, value);
+        if (_ditherMask & (1 << channel)) {
+            v += _ditherError[channel];
+            _ditherError[channel] = v & ((1 << FracBits) - 1);
+        }
+        return v >> FracBits;
+    }
+
+    static Curve curveFromName(const String& name);
+
+private:
+    uint16_t _tables[NumChannels][Size + 1];
+    uint32_t _step = 0;
+    uint32_t _brightness[NumChannels] = { 65536, 65536, 65536, 65536, 65536 };
+    bool _identity = true;
+    uint8_t _ditherMask = 0;
+    uint8_t _ditherError[NumChannels] = {};
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <RGBWWLed/RGBWWLedColor.h>
+
+// Estimates the supply current from the PWM duty of each channel and scales
+// all channels down by the same factor when the estimate exceeds the budget.
+// Integer only, so it can run on every LED step.
+class PowerLimiter {
+public:
+    static const unsigned NumChannels = 5;
+
+    // current per channel at full duty in mA (0: not modeled), budget 0: no limit
+    void configure(const int currentMa[NumChannels], int budgetMa);
+    bool hasModel() const { return _hasModel; }
+
+    void apply(ChannelOutput& output);
+
+    // estimated current of the last output in mA, after limiting
+    uint32_t getCurrent() const { return _current; }
+    bool isLimited() const { return _limited; }
+
+private:
+    uint32_t estimate(const ChannelOutput& output) const {
+        return (output.r * _coef[0] + output.g * _coef[1] + output.b * _coef[2] +
+                output.ww * _coef[3] + output.cw * _coef[4]) >> 10;
+    }
+
+    // mA per PWM unit in Q10
+    uint32_t _coef[NumChannels] = {};
+    uint32_t _budget = 0;
+    uint32_t _current = 0;
+    bool _hasModel = false;
+    bool _limited = false;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#define APP_SCENES_FILE ".scenes"
+#define APP_SCENES_MAX 16
+#define APP_SCENE_MAXSTEPS 4
+#define APP_SCENE_NAMELEN 16
+
+// One color command of a scene. Values are stored in RGBWWLed calculation
+// units, so recalling a scene does not need any parsing or conversion.
+struct SceneStep {
+    enum Mode : uint8_t {
+        Hsv = 0,
+        Raw = 1,
+    };
+
+    uint8_t mode = Hsv;
+    uint8_t fade = 0;
+    uint8_t mask = 0;       // bit n set: values[n] is used
+    uint8_t direction = 1;
+    int16_t values[5] = {}; // h, s, v, ct or r, g, b, ww, cw
+    uint32_t ramp = 0;      // ms
+};
+
+struct Scene {
+    uint8_t used = 0;
+    uint8_t numSteps = 0;
+    char name[APP_SCENE_NAMELEN] = {};
+    SceneStep steps[APP_SCENE_MAXSTEPS];
+};
+
+// Fixed slot table on the filesystem. The scene id is the slot index, so
+// loading and storing a scene is a single seek plus read/write.
+class SceneStorage {
+public:
+    bool load(uint8_t id, Scene& scene);
+    bool save(uint8_t id, const Scene& scene);
+    bool remove(uint8_t id);
+
+private:
+    static bool isValidId(uint8_t id);
+    bool ensureFile();
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <RGBWWLed/RGBWWLed.h>
+#include "channelmask.h"
+#include "transition.h"
+
+#define APP_SEQUENCE_FILEPREFIX ".seq_"
+#define APP_SEQUENCE_MAXNAMELEN 16
+#define APP_SEQUENCE_MAXSIZE 4096
+#define APP_SEQUENCE_MAXLOOPDEPTH 4
+
+/*
+ * Stored animation sequence in a compact bytecode, interpreted while playing.
+ *
+ * Layout: 4 byte header "RWS" + version, followed by instructions. All
+ * numbers are little endian, color values are in RGBWWLed calculation units.
+ *
+ *   0x00 End
+ *   0x01 FadeHsv   h, s, v, ct (u16 each), time ms (u32)
+ *   0x02 FadeRaw   r, g, b, ww, cw (u16 each), time ms (u32)
+ *   0x03 Hold      time ms (u32)
+ *   0x04 Loop      count (u16, 0 = forever)
+ *   0x05 EndLoop
+ *   0x06 Channels  channel mask (u16) applied to the following fades
+ *   0x07 Ease      Easing::Curve (u8) applied to the following fades
+ *
+ * The file stays open while playing and is read through a small window,
+ * so RAM usage does not depend on the length of the sequence and a step
+ * only touches the filesystem when the program counter leaves the window.
+ */
+class SequencePlayer {
+public:
+    enum Opcode : uint8_t {
+        End = 0x00,
+        FadeHsv = 0x01,
+        FadeRaw = 0x02,
+        Hold = 0x03,
+        Loop = 0x04,
+        EndLoop = 0x05,
+        Channels = 0x06,
+        Ease = 0x07,
+    };
+
+    static const uint8_t Version = 1;
+    static const size_t HeaderSize = 4;
+    static const size_t MaxInstructionSize = 15;
+    static const size_t WindowSize = 128;
+
+    static bool isValidName(const String& name);
+    static bool validate(const String& program, String& msg);
+    static bool store(const String& name, const String& program, String& msg);
+    static void writeHeader(String& program);
+    static size_t instructionSize(uint8_t opcode);
+
+    bool start(const String& name);
+    void stop();
+    bool isActive() const { return _active; }
+    const String& getName() const { return _name; }
+
+    // advance by one LED step and write the resulting color to led
+    // returns false when the sequence has finished
+    bool process(RGBWWLed& led);
+
+private:
+    struct LoopState {
+        uint32_t begin;
+        uint16_t remaining;
+    };
+
+    const uint8_t* fetch();
+    bool execute(RGBWWLed& led);
+    void close();
+
+    String _name;
+    bool _active = false;
+    uint32_t _pc = 0;
+
+    // open program file and the part of it around the program counter
+    file_t _file = -1;
+    uint8_t _window[WindowSize];
+    uint32_t _windowStart = 0;
+    uint16_t _windowLen = 0;
+    bool _windowAtEnd = false;
+
+    LoopState _loops[APP_SEQUENCE_MAXLOOPDEPTH];
+    uint8_t _loopDepth = 0;
+
+    ChannelMask _channels = 0;
+    uint8_t _ease = 0;
+
+    // running timed instruction
+    Transition _transition;
+    uint32_t _steps = 0;
+    uint32_t _elapsed = 0;
+};
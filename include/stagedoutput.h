@@ -0,0 +1,19 @@
+#pragma once
+
+#include <RGBWWLed/RGBWWLed.h>
+
+// The PWM output the library writes through. RGBWWLed writes every step in
+// show() and on every direct color, before the app's output stage has run.
+// Those writes are held back; APPLedCtrl::writeOutput() sends each step to
+// the hardware once, after calibration, dimming tables and power limit, so
+// no uncorrected or unlimited value reaches the LEDs.
+class StagedPWMOutput : public PWMOutput {
+public:
+    using PWMOutput::PWMOutput;
+
+    void setOutput(int red, int green, int blue, int warmwhite, int coldwhite) override {}
+
+    void write(const ChannelOutput& output) {
+        PWMOutput::setOutput(output.r, output.g, output.b, output.ww, output.cw);
+    }
+};
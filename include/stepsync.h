@@ -2,13 +2,47 @@
 
 #include <limits>
 
+#define APP_STEPSYNC_FILE ".stepsync"
 
+/*
+ * Keeps the local step counter in sync with a master clock.
+ *
+ * The frequency error of the local timer against the master is estimated
+ * separately from the phase offset: master steps and the local time spent
+ * on them (local steps times the interval they ran with) are summed over a
+ * baseline of up to hours. One sync period is far too short, a step of
+ * rounding or delivery delay in a 30 s period is already several hundred
+ * ppm. The phase offset is removed proportionally on top of the frequency
+ * corrected interval, so a master restart only needs a phase relock while
+ * the learned drift is kept.
+ *
+ * The step counters alone resolve the phase to a step. A master clock that
+ * also tells how far into its step it was (the UDP clock) is steered in
+ * microseconds instead.
+ */
 class StepSync {
 public:
-    uint32_t onMasterClock(uint32_t stepsCurrent, uint32_t stepsMaster);
+    static const int32_t NoSubStep = std::numeric_limits<int32_t>::min();
+
+    // subStepUs: time the master was further into its step than the local timer, if known
+    uint32_t onMasterClock(uint32_t stepsCurrent, uint32_t stepsMaster, int32_t subStepUs = NoSubStep);
     int getCatchupOffset() const;
     uint32_t reset();
 
+    // frequency error of the local timer in ppm, positive: local steps take longer than the master's
+    int getDrift() const { return _driftPpm; }
+    bool isLocked() const { return _locked; }
+
+    // convert between master and local step counter, false while there is no master clock
+    bool toLocalSteps(uint32_t masterSteps, uint32_t& steps) const;
+    bool toMasterSteps(uint32_t steps, uint32_t& masterSteps) const;
+
+    // learned drift, persisted so a reboot starts with the right frequency
+    void load();
+    void save();
+    // save a drift that changed since the last save, e.g. before a restart
+    void flush();
+
 protected:
     template<typename T>
     static T calcOverflowVal(T prevValue, T curValue) {
@@ -21,12 +55,43 @@ protected:
         }
     }
 
+    uint32_t frequencyInterval() const;
+    void resetBaseline();
+    void updateDrift(int masterDiff, int diff);
+
     int _catchupOffset = 0;
+    // sub-step phase when it became known, the reference like the step counters at the first sync
+    int32_t _subStepRefUs = 0;
+    bool _hasSubStep = false;
 
 private:
+    // larger deviations are steps lost locally, not a frequency error
+    static const int _maxDriftPpm = 20000;
+    // offsets in steps for gaining and losing the lock
+    static const int _lockOffset = 2;
+    static const int _unlockOffset = 8;
+    // drift estimate from at least 15 min of master steps, older data fades out after 4 h
+    static const uint32_t _minBaselineSteps = 15 * 60 * RGBWW_UPDATEFREQUENCY;
+    static const uint32_t _maxBaselineSteps = 4 * 3600 * RGBWW_UPDATEFREQUENCY;
+    // flash wear: save at most every 6 h unless the drift moved by a lot
+    static const uint32_t _saveIntervalSteps = 6 * 3600 * RGBWW_UPDATEFREQUENCY;
+    static const int _saveDeviationPpm = 2;
+    static const int _saveLargeDeviationPpm = 50;
+
     uint32_t _stepsSyncMasterLast = 0;
     uint32_t _stepsSyncLast = 0;
+    uint32_t _interval = RGBWW_MINTIMEDIFF_US;
     bool _firstMasterSync = true;
-    double _steering = 1.0;
+    bool _driftValid = false;
+    int _driftPpm = 0;
+    int _savedDriftPpm = 0;
+    uint32_t _stepsSinceSave = 0;
+    // baseline of the drift estimate
+    uint32_t _baselineMasterSteps = 0;
+    uint64_t _baselineLocalUs = 0;
+    uint8_t _lockCount = 0;
+    bool _locked = false;
+    bool _hasMaster = false;
+    uint32_t _masterOffset = 0;
     const uint32_t _constBaseInt = RGBWW_MINTIMEDIFF_US;
 };
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <RGBWWLed/RGBWWLed.h>
+#include "channelmask.h"
+#include "easing.h"
+#include "oklab.h"
+
+// Fade between two colors computed by the app on every LED step, used where
+// the library fades cannot do the job (easing curves, sequences). Only the
+// channels in the mask are written, the others keep their current value.
+class Transition {
+public:
+    // direction like the library's fades: 1 takes the shorter way around the hue wheel, 0 the longer one
+    void startHsv(const HSVCT& from, const HSVCT& to, uint32_t ms, uint8_t ease, ChannelMask channels, int direction = 1);
+    void startRaw(const ChannelOutput& from, const ChannelOutput& to, uint32_t ms, uint8_t ease, ChannelMask channels);
+
+    // red, green and blue are interpolated in Oklab, the white channels linearly.
+    // With an HSV target the fade ends in HSV mode on exactly that color.
+    void startOklab(const ChannelOutput& from, const ChannelOutput& to, uint32_t ms, uint8_t ease);
+    void startOklab(const ChannelOutput& from, const ChannelOutput& to, const HSVCT& hsvTarget, uint32_t ms, uint8_t ease);
+    void stop() { _active = false; }
+    bool isActive() const { return _active; }
+
+    // advance by one LED step and write the resulting color to led
+    // returns false after the target color has been written
+    bool process(RGBWWLed& led);
+
+private:
+    enum class Space : uint8_t {
+        Hsv,
+        Raw,
+        Oklab,
+    };
+
+    void start(uint32_t ms, uint8_t ease, ChannelMask channels);
+    void write(RGBWWLed& led, const int val[5]);
+    void finish(RGBWWLed& led);
+
+    bool _active = false;
+    Space _space = Space::Hsv;
+    uint8_t _ease = Easing::Linear;
+    ChannelMask _channels = 0;
+    uint32_t _steps = 0;
+    uint32_t _elapsed = 0;
+    int _from[5] = {};
+    int _to[5] = {};
+
+    // exact end point of an Oklab fade
+    ChannelOutput _rawTarget;
+    HSVCT _hsvTarget;
+    bool _hasHsvTarget = false;
+};
@@ -72,6 +72,11 @@ private:
     void onContinue(HttpRequest &request, HttpResponse &response);
     void onBlink(HttpRequest &request, HttpResponse &response);
     void onToggle(HttpRequest &request, HttpResponse &response);
+    void onScene(HttpRequest &request, HttpResponse &response);
+    void onEffect(HttpRequest &request, HttpResponse &response);
+    void onScenes(HttpRequest &request, HttpResponse &response);
+    void onSequence(HttpRequest &request, HttpResponse &response);
+    void onSequences(HttpRequest &request, HttpResponse &response);
 
     void onColorGet(HttpRequest &request, HttpResponse &response);
     void onColorPost(HttpRequest &request, HttpResponse &response);
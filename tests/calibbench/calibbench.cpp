@@ -0,0 +1,112 @@
+/*
+ * Host benchmark of the per device color calibration.
+ *
+ * Times ColorCalibration::apply(), the Q12 fixed-point 3x3 + 2x2 matrix run
+ * on every LED step, against the same matrix evaluated in float, and
+ * reports the difference between both in RGBWWLed units.
+ *
+ * Build and run from the repository root:
+ *
+ *   g++ -std=c++17 -O2 -Itests/host -Iinclude tests/calibbench/calibbench.cpp \
+ *       app/calibration.cpp -o calibbench
+ *   ./calibbench
+ *
+ * Exits with 1 if the fixed-point result is more than one unit off.
+ */
+
+#include <RGBWWCtrl.h>
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const unsigned iterations = 2000000;
+
+// a typical correction: slightly desaturated green, blue leaking into green, cooler cold white
+const float rgb[9] = {
+    0.95f, 0.05f, 0.0f,
+    0.02f, 0.90f, 0.08f,
+    0.0f, 0.03f, 0.97f,
+};
+const float white[4] = {
+    1.0f, 0.0f,
+    0.05f, 0.95f,
+};
+
+// keeps the compiler from dropping the work
+volatile int sink = 0;
+
+int clampFloat(float v) {
+    return static_cast<int>(constrain(v, 0.0f, float(RGBWW_CALC_MAXVAL)));
+}
+
+void applyFloat(ChannelOutput& output) {
+    const float r = output.r, g = output.g, b = output.b;
+    output.r = clampFloat(rgb[0] * r + rgb[1] * g + rgb[2] * b);
+    output.g = clampFloat(rgb[3] * r + rgb[4] * g + rgb[5] * b);
+    output.b = clampFloat(rgb[6] * r + rgb[7] * g + rgb[8] * b);
+
+    const float ww = output.ww, cw = output.cw;
+    output.ww = clampFloat(white[0] * ww + white[1] * cw);
+    output.cw = clampFloat(white[2] * ww + white[3] * cw);
+}
+
+std::vector<ChannelOutput> makeInputs() {
+    std::vector<ChannelOutput> inputs(4096);
+    for (unsigned i=0; i < inputs.size(); ++i) {
+        inputs[i].r = (i * 7) % (RGBWW_CALC_MAXVAL + 1);
+        inputs[i].g = (i * 13) % (RGBWW_CALC_MAXVAL + 1);
+        inputs[i].b = (i * 29) % (RGBWW_CALC_MAXVAL + 1);
+        inputs[i].ww = (i * 3) % (RGBWW_CALC_MAXVAL + 1);
+        inputs[i].cw = (i * 17) % (RGBWW_CALC_MAXVAL + 1);
+    }
+    return inputs;
+}
+
+template<typename F>
+double measure(const std::vector<ChannelOutput>& inputs, F stage) {
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned i=0; i < iterations; ++i) {
+        ChannelOutput output = inputs[i % inputs.size()];
+        stage(output);
+        sink += output.r + output.g + output.b + output.ww + output.cw;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+}
+
+int main() {
+    const std::vector<ChannelOutput> inputs = makeInputs();
+
+    ColorCalibration calibration;
+    calibration.build(rgb, white);
+
+    ColorCalibration identity;
+    const float rgbIdentity[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+    const float whiteIdentity[4] = { 1, 0, 0, 1 };
+    identity.build(rgbIdentity, whiteIdentity);
+
+    printf("%-28s %8s\n", "calibration per step", "ns");
+    printf("%-28s %8.1f\n", "identity (skipped)", measure(inputs, [&](ChannelOutput& o) {
+        if (!identity.isIdentity())
+            identity.apply(o);
+    }));
+    printf("%-28s %8.1f\n", "float matrix", measure(inputs, applyFloat));
+    printf("%-28s %8.1f\n", "Q12 matrix", measure(inputs, [&](ChannelOutput& o) { calibration.apply(o); }));
+
+    int maxError = 0;
+    for (const ChannelOutput& input : inputs) {
+        ChannelOutput fixed = input;
+        ChannelOutput exact = input;
+        calibration.apply(fixed);
+        applyFloat(exact);
+        maxError = std::max({ maxError, std::abs(fixed.r - exact.r), std::abs(fixed.g - exact.g),
+                std::abs(fixed.b - exact.b), std::abs(fixed.ww - exact.ww), std::abs(fixed.cw - exact.cw) });
+    }
+    printf("\nQ12 vs float: max difference %d units over %zu inputs\n", maxError, inputs.size());
+    return maxError <= 1 ? 0 : 1;
+}
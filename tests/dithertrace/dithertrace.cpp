@@ -0,0 +1,99 @@
+/*
+ * Host trace of the temporal dithering in the output tables.
+ *
+ * A constant input is pushed through the dithered OutputLut kernel tick by
+ * tick like APPLedCtrl::writeOutput() does. For each input the trace shows
+ * the table value with its fraction bits, the PWM values of the first
+ * ticks, the average over whole patterns and the pattern length. The
+ * pattern toggles by one PWM step, its length sets the lowest flicker
+ * frequency at the LED step rate.
+ *
+ * Build and run from the repository root:
+ *
+ *   g++ -std=c++17 -O2 -Itests/host -Iinclude tests/dithertrace/dithertrace.cpp \
+ *       app/outputlut.cpp -o dithertrace
+ *   ./dithertrace [input ...]
+ *
+ * Inputs are 0..RGBWW_CALC_MAXVAL on the red channel with the CIE 1931
+ * curve, a few low levels by default. Exits with 1 if an average differs
+ * from the table value.
+ */
+
+#include <RGBWWCtrl.h>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const unsigned FracOne = 1 << OutputLut::FracBits;
+const unsigned traceTicks = 32;
+const double stepRateHz = 1000.0 / RGBWW_MINTIMEDIFF;
+
+// ticks until the accumulated error repeats
+unsigned patternLength(unsigned fraction) {
+    unsigned error = 0;
+    for (unsigned tick=1; tick <= FracOne; ++tick) {
+        error = (error + fraction) % FracOne;
+        if (error == 0)
+            return tick;
+    }
+    return FracOne;
+}
+
+bool trace(OutputLut& lut, int input) {
+    const uint32_t table = lut.lookup(0, input);
+    const unsigned fraction = table & (FracOne - 1);
+    const unsigned length = patternLength(fraction);
+
+    // the accumulator starts empty for every input
+    lut.setDithering(0x01);
+
+    printf("input %4d  table %4u + %2u/%u  ", input, table >> OutputLut::FracBits, fraction, FracOne);
+    // every pattern length divides FracOne, so this averages whole patterns
+    std::vector<int> values;
+    for (unsigned tick=0; tick < FracOne * FracOne; ++tick) {
+        ChannelOutput output;
+        output.r = input;
+        OutputLut::applyKernel<RGB>(lut, output);
+        values.push_back(output.r);
+    }
+
+    for (unsigned tick=0; tick < traceTicks; ++tick)
+        printf("%d%s", values[tick] - static_cast<int>(table >> OutputLut::FracBits), (tick % 16 == 15) ? " " : "");
+
+    double sum = 0;
+    for (int v : values)
+        sum += v;
+    const double average = sum / values.size();
+    const double expected = double(table) / FracOne;
+    const bool ok = std::fabs(average - expected) < 1e-9;
+
+    printf(" avg %8.4f  pattern %2u ticks", average, length);
+    if (fraction != 0)
+        printf(" = %5.2f Hz", stepRateHz / length);
+    printf("%s\n", ok ? "" : "  FAIL");
+    return ok;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> inputs;
+    for (int i=1; i < argc; ++i)
+        inputs.push_back(constrain(atoi(argv[i]), 0, RGBWW_CALC_MAXVAL));
+    if (inputs.empty())
+        inputs = { 1, 10, 20, 40, 60, 80, 100, 150, 200, 300, 512 };
+
+    const int brightness[OutputLut::NumChannels] = { 100, 100, 100, 100, 100 };
+    OutputLut lut;
+    lut.build(brightness, OutputLut::Curve::Cie1931, 100);
+
+    printf("PWM offset from the table value per tick, %.0f ticks per second\n", stepRateHz);
+    bool ok = true;
+    for (int input : inputs)
+        ok &= trace(lut, input);
+
+    printf("\nlongest pattern %u ticks: a one step pattern at %.2f Hz\n", FracOne, stepRateHz / FracOne);
+    return ok ? 0 : 1;
+}
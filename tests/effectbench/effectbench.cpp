@@ -0,0 +1,126 @@
+/*
+ * Host benchmark of the effect engine cost per LED tick.
+ *
+ * Times EffectEngine::apply() for every effect on an HSV color and on a
+ * raw output, the work APPLedCtrl::applyEffect() adds to each step before
+ * the output stage. Over one full period of each effect the range of the
+ * modulated level is reported as well, to check it stays within min/max.
+ *
+ * Build and run from the repository root:
+ *
+ *   g++ -std=c++17 -O2 -Itests/host -Iinclude tests/effectbench/effectbench.cpp \
+ *       app/effects.cpp -o effectbench
+ *   ./effectbench
+ *
+ * Exits with 1 if a level leaves the configured range or an effect jumps
+ * in phase where step * RGBWW_MINTIMEDIFF overflows 32 bits (~49.7 days).
+ */
+
+#include <RGBWWCtrl.h>
+
+#include <chrono>
+
+namespace {
+
+const unsigned iterations = 2000000;
+const EffectEngine::Effect effects[] = {
+    EffectEngine::Effect::Rainbow,
+    EffectEngine::Effect::Breathe,
+    EffectEngine::Effect::Candle,
+    EffectEngine::Effect::Strobe,
+};
+
+// keeps the compiler from dropping the work
+volatile int sink = 0;
+
+template<typename F>
+double measure(F tick) {
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned step=0; step < iterations; ++step)
+        tick(step);
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+EffectEngine::Params makeParams(EffectEngine::Effect effect) {
+    EffectEngine::Params params;
+    params.effect = effect;
+    params.period = (effect == EffectEngine::Effect::Candle) ? 200 : 4000;
+    params.min = 13107; // 20%
+    params.max = 58982; // 90%
+    return params;
+}
+
+}
+
+int main() {
+    HSVCT color;
+    color.h = 100;
+    color.s = RGBWW_CALC_MAXVAL;
+    color.v = RGBWW_CALC_MAXVAL;
+    color.ct = 2700;
+
+    ChannelOutput output;
+    output.r = RGBWW_CALC_MAXVAL;
+    output.g = RGBWW_CALC_MAXVAL / 2;
+    output.b = RGBWW_CALC_MAXVAL / 4;
+    output.ww = RGBWW_CALC_MAXVAL;
+    output.cw = 0;
+
+    bool ok = true;
+    bool wrapOk = true;
+    printf("%-10s %8s %8s %10s %10s\n", "effect", "hsv ns", "raw ns", "min v", "max v");
+    for (EffectEngine::Effect effect : effects) {
+        EffectEngine engine;
+        engine.start(makeParams(effect));
+
+        const double hsvNs = measure([&](uint32_t step) {
+            HSVCT c = color;
+            engine.apply(step, c);
+            sink += c.h + c.v;
+        });
+        const double rawNs = measure([&](uint32_t step) {
+            ChannelOutput o = output;
+            engine.apply(step, o);
+            sink += o.r + o.ww;
+        });
+
+        // value range over one period, rainbow leaves the value alone
+        const uint32_t periodSteps = engine.getParams().period / RGBWW_MINTIMEDIFF;
+        int minV = RGBWW_CALC_MAXVAL;
+        int maxV = 0;
+        for (uint32_t step=0; step < periodSteps * 4; ++step) {
+            HSVCT c = color;
+            engine.apply(step, c);
+            minV = std::min(minV, c.v);
+            maxV = std::max(maxV, c.v);
+        }
+
+        const EffectEngine::Params& params = engine.getParams();
+        const int lowest = (RGBWW_CALC_MAXVAL * params.min) >> 16;
+        const int highest = (RGBWW_CALC_MAXVAL * params.max) >> 16;
+        if (effect != EffectEngine::Effect::Rainbow && (minV < lowest || maxV > highest + 1))
+            ok = false;
+
+        printf("%-10s %8.1f %8.1f %10d %10d\n", EffectEngine::toName(effect), hsvNs, rawNs, minV, maxV);
+
+        // one period later the color must be the same, also across the step where ms wrapped.
+        // The candle noise differs per period, its level range is checked above.
+        const uint32_t wrapStep = 0xffffffffu / RGBWW_MINTIMEDIFF;
+        if (effect == EffectEngine::Effect::Candle)
+            continue;
+        for (uint32_t step=wrapStep - 2 * periodSteps; step < wrapStep + 2 * periodSteps; ++step) {
+            HSVCT a = color;
+            HSVCT b = color;
+            engine.apply(step, a);
+            engine.apply(step + periodSteps, b);
+            if (a.h != b.h || a.v != b.v)
+                wrapOk = false;
+        }
+    }
+
+    printf("level range %s\n", ok ? "ok" : "FAIL");
+    printf("phase across the ms wrap %s\n", wrapOk ? "ok" : "FAIL");
+    ok &= wrapOk;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/*
+ * Host accuracy test of the Oklab conversion and benchmark of the
+ * transition step cost.
+ *
+ * Every RGB color on a grid is converted with Oklab::fromRgb() and back
+ * with the fixed-point Oklab::toRgb() that runs on every step of an Oklab
+ * fade. The round trip error and the error of toRgb() against the same
+ * conversion in double precision are reported in RGBWWLed units.
+ *
+ * The second part times Transition::process() per LED step for HSV, raw
+ * and Oklab fades, with and without an easing curve.
+ *
+ * Build and run from the repository root:
+ *
+ *   g++ -std=c++17 -O2 -Itests/host -Iinclude tests/fadebench/fadebench.cpp \
+ *       app/oklab.cpp app/transition.cpp app/easing.cpp -o fadebench
+ *   ./fadebench
+ *
+ * Exits with 1 if the round trip error exceeds MaxRoundTripError.
+ */
+
+#include <RGBWWCtrl.h>
+
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+const int MaxRoundTripError = 2;
+const int GridStep = 31;
+const unsigned fadeSteps = 1000;
+const unsigned repeats = 200;
+
+// Oklab to linear sRGB in double precision, the reference for toRgb()
+void referenceToRgb(const Oklab::Lab& lab, double rgb[3]) {
+    const double L = lab.L / 32768.0;
+    const double a = lab.a / 32768.0;
+    const double b = lab.b / 32768.0;
+
+    const double l = std::pow(L + 0.3963377774 * a + 0.2158037573 * b, 3);
+    const double m = std::pow(L - 0.1055613458 * a - 0.0638541728 * b, 3);
+    const double s = std::pow(L - 0.0894841775 * a - 1.2914855480 * b, 3);
+
+    rgb[0] = 4.0767416621 * l - 3.3077115913 * m + 0.2309699292 * s;
+    rgb[1] = -1.2684380046 * l + 2.6097574011 * m - 0.3413193965 * s;
+    rgb[2] = -0.0041960863 * l - 0.7034186147 * m + 1.7076147010 * s;
+    for (int i=0; i < 3; ++i)
+        rgb[i] = std::min(std::max(rgb[i], 0.0), 1.0) * RGBWW_CALC_MAXVAL;
+}
+
+struct ErrorStats {
+    double max = 0;
+    double sum = 0;
+    unsigned count = 0;
+
+    void add(double error) {
+        max = std::max(max, error);
+        sum += error;
+        ++count;
+    }
+
+    double mean() const { return count ? sum / count : 0; }
+};
+
+bool accuracy() {
+    ErrorStats roundTrip;
+    ErrorStats fixedPoint;
+    int worst[3] = {};
+
+    for (int r=0; r <= RGBWW_CALC_MAXVAL; r += GridStep) {
+        for (int g=0; g <= RGBWW_CALC_MAXVAL; g += GridStep) {
+            for (int b=0; b <= RGBWW_CALC_MAXVAL; b += GridStep) {
+                const Oklab::Lab lab = Oklab::fromRgb(r, g, b);
+                int out[3];
+                Oklab::toRgb(lab, out[0], out[1], out[2]);
+
+                double reference[3];
+                referenceToRgb(lab, reference);
+
+                const int in[3] = { r, g, b };
+                for (int i=0; i < 3; ++i) {
+                    const double error = std::abs(out[i] - in[i]);
+                    if (error > roundTrip.max) {
+                        worst[0] = r;
+                        worst[1] = g;
+                        worst[2] = b;
+                    }
+                    roundTrip.add(error);
+                    fixedPoint.add(std::fabs(out[i] - reference[i]));
+                }
+            }
+        }
+    }
+
+    printf("%-28s %8s %8s\n", "oklab error", "max", "mean");
+    printf("%-28s %8.2f %8.3f\n", "round trip", roundTrip.max, roundTrip.mean());
+    printf("%-28s %8.2f %8.3f\n", "toRgb vs double", fixedPoint.max, fixedPoint.mean());
+    printf("worst round trip at rgb %d, %d, %d, %u values checked\n\n", worst[0], worst[1], worst[2], roundTrip.count);
+    return roundTrip.max <= MaxRoundTripError;
+}
+
+// keeps the compiler from dropping the work
+volatile int sink = 0;
+
+template<typename F>
+double measure(F startFade) {
+    RGBWWLed led;
+    unsigned steps = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned i=0; i < repeats; ++i) {
+        Transition transition;
+        startFade(transition);
+        while (transition.process(led))
+            ++steps;
+        ++steps;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    sink += led.getCurrentOutput().r + led.getCurrentColor().v;
+    return std::chrono::duration<double, std::nano>(end - start).count() / steps;
+}
+
+void stepCost() {
+    const uint32_t ms = fadeSteps * RGBWW_MINTIMEDIFF;
+
+    HSVCT hsvFrom, hsvTo;
+    hsvFrom.s = hsvTo.s = RGBWW_CALC_MAXVAL;
+    hsvFrom.v = hsvTo.v = RGBWW_CALC_MAXVAL;
+    hsvTo.h = RGBWW_CALC_HUEWHEELMAX / 2;
+
+    ChannelOutput red, blue;
+    red.r = RGBWW_CALC_MAXVAL;
+    blue.b = RGBWW_CALC_MAXVAL;
+    blue.ww = RGBWW_CALC_MAXVAL / 2;
+
+    printf("%-28s %8s\n", "transition step", "ns");
+    printf("%-28s %8.1f\n", "hsv linear", measure([&](Transition& t) { t.startHsv(hsvFrom, hsvTo, ms, Easing::Linear, 0); }));
+    printf("%-28s %8.1f\n", "hsv in_out", measure([&](Transition& t) { t.startHsv(hsvFrom, hsvTo, ms, Easing::InOut, 0); }));
+    printf("%-28s %8.1f\n", "raw linear", measure([&](Transition& t) { t.startRaw(red, blue, ms, Easing::Linear, 0); }));
+    printf("%-28s %8.1f\n", "raw cie", measure([&](Transition& t) { t.startRaw(red, blue, ms, Easing::Cie, 0); }));
+    printf("%-28s %8.1f\n", "oklab linear", measure([&](Transition& t) { t.startOklab(red, blue, ms, Easing::Linear); }));
+    printf("%-28s %8.1f\n", "oklab in_out", measure([&](Transition& t) { t.startOklab(red, blue, ms, Easing::InOut); }));
+
+    // the endpoints need a cube root each, done once per fade
+    Transition transition;
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned i=0; i < repeats * 100; ++i) {
+        red.g = i % RGBWW_CALC_MAXVAL;
+        transition.startOklab(red, blue, ms, Easing::Linear);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    printf("%-28s %8.1f\n", "oklab fade start", std::chrono::duration<double, std::nano>(end - start).count() / (repeats * 100));
+}
+
+}
+
+int main() {
+    const bool ok = accuracy();
+    stepCost();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+// Minimal stand-ins for the firmware environment, shared by the host tools
+// that build the app's color code (transitions, sequences, output stage).
+// Files live in memory and every filesystem call is counted.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+#define debug_d(...)
+#define debug_i(...)
+#define debug_w(...)
+#define debug_e(...)
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+class String : public std::string {
+public:
+    String() = default;
+    String(const char* text) : std::string(text) {}
+    String(const std::string& text) : std::string(text) {}
+
+    unsigned length() const { return size(); }
+
+    String& operator+=(char c) {
+        push_back(c);
+        return *this;
+    }
+
+    String& operator+=(const char* text) {
+        append(text);
+        return *this;
+    }
+
+    String& operator+=(size_t value) {
+        append(std::to_string(value));
+        return *this;
+    }
+};
+
+inline String operator+(const String& a, const String& b) {
+    return String(static_cast<const std::string&>(a) + static_cast<const std::string&>(b));
+}
+
+namespace HostFs {
+    struct Stats {
+        unsigned opens = 0;
+        unsigned seeks = 0;
+        unsigned reads = 0;
+    };
+
+    struct OpenFile {
+        std::string name;
+        size_t pos = 0;
+        bool used = false;
+    };
+
+    inline std::map<std::string, std::string> files;
+    inline OpenFile handles[4];
+    inline Stats stats;
+}
+
+typedef int file_t;
+
+enum FileOpenFlags {
+    eFO_ReadOnly = 1,
+};
+
+enum SeekOriginFlags {
+    eSO_FileStart = 0,
+};
+
+inline bool fileExist(const String& name) {
+    return HostFs::files.count(name) > 0;
+}
+
+inline int fileSetContent(const String& name, const String& content) {
+    HostFs::files[name] = content;
+    return content.length();
+}
+
+inline file_t fileOpen(const String& name, int) {
+    ++HostFs::stats.opens;
+    if (!fileExist(name))
+        return -1;
+
+    for (file_t f=0; f < 4; ++f) {
+        if (!HostFs::handles[f].used) {
+            HostFs::handles[f] = { name, 0, true };
+            return f;
+        }
+    }
+    return -1;
+}
+
+inline int fileSeek(file_t file, int offset, int) {
+    ++HostFs::stats.seeks;
+    HostFs::handles[file].pos = offset;
+    return offset;
+}
+
+inline int fileRead(file_t file, void* data, size_t size) {
+    ++HostFs::stats.reads;
+    HostFs::OpenFile& handle = HostFs::handles[file];
+    const std::string& content = HostFs::files[handle.name];
+    if (handle.pos >= content.size())
+        return 0;
+
+    const size_t len = std::min(size, content.size() - handle.pos);
+    memcpy(data, content.data() + handle.pos, len);
+    handle.pos += len;
+    return len;
+}
+
+inline void fileClose(file_t file) {
+    HostFs::handles[file].used = false;
+}
+
+#include <RGBWWLed/RGBWWLed.h>
+#include <easing.h>
+#include <oklab.h>
+#include <transition.h>
+#include <sequence.h>
+#include <effects.h>
+#include <outputlut.h>
+#include <calibration.h>
@@ -0,0 +1,50 @@
+#pragma once
+
+// The part of RGBWWLed the app's transitions and sequences write to. Colors
+// are stored as given, HSV and raw are not converted into each other.
+
+#include "RGBWWLedColor.h"
+
+class RGBWWLed {
+public:
+    const HSVCT& getCurrentColor() const { return _color; }
+    const ChannelOutput& getCurrentOutput() const { return _output; }
+
+    void colorDirectHSV(const HSVCT& color) {
+        _color = color;
+        ++writes;
+    }
+
+    void colorDirectHSV(const RequestHSVCT& color) {
+        assign(_color.h, color.h);
+        assign(_color.s, color.s);
+        assign(_color.v, color.v);
+        assign(_color.ct, color.ct);
+        ++writes;
+    }
+
+    void colorDirectRAW(const ChannelOutput& output) {
+        _output = output;
+        ++writes;
+    }
+
+    void colorDirectRAW(const RequestChannelOutput& output) {
+        assign(_output.r, output.r);
+        assign(_output.g, output.g);
+        assign(_output.b, output.b);
+        assign(_output.ww, output.ww);
+        assign(_output.cw, output.cw);
+        ++writes;
+    }
+
+    unsigned writes = 0;
+
+private:
+    static void assign(int& value, const AbsOrRelValue& request) {
+        if (request.hasValue())
+            value = request.getValue();
+    }
+
+    HSVCT _color;
+    ChannelOutput _output;
+};
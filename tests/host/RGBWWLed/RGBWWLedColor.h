@@ -0,0 +1,76 @@
+#pragma once
+
+// Color types and calculation constants of the RGBWWLed library, reduced to
+// what the app's color code uses.
+
+#include <cstdint>
+
+#define RGBWW_MINTIMEDIFF 20
+#define RGBWW_MINTIMEDIFF_US (RGBWW_MINTIMEDIFF * 1000)
+
+#define RGBWW_CALC_DEPTH 10
+#define RGBWW_CALC_MAXVAL ((1 << RGBWW_CALC_DEPTH) - 1)
+#define RGBWW_CALC_HUEWHEELMAX (RGBWW_CALC_MAXVAL * 6)
+
+enum RGBWW_COLORMODE {
+    RGB = 0,
+    RGBWW = 1,
+    RGBCW = 2,
+    RGBWWCW = 3,
+};
+
+enum class CtrlChannel {
+    Hue,
+    Sat,
+    Val,
+    ColorTemp,
+    Red,
+    Green,
+    Blue,
+    WarmWhite,
+    ColdWhite,
+};
+
+struct HSVCT {
+    int h = 0;
+    int s = 0;
+    int v = 0;
+    int ct = 0;
+};
+
+struct ChannelOutput {
+    int r = 0;
+    int g = 0;
+    int b = 0;
+    int ww = 0;
+    int cw = 0;
+};
+
+// absolute value, an unset value leaves the channel unchanged
+class AbsOrRelValue {
+public:
+    AbsOrRelValue() = default;
+    explicit AbsOrRelValue(int value) : _value(value), _set(true) {}
+
+    bool hasValue() const { return _set; }
+    int getValue() const { return _value; }
+
+private:
+    int _value = 0;
+    bool _set = false;
+};
+
+struct RequestHSVCT {
+    AbsOrRelValue h;
+    AbsOrRelValue s;
+    AbsOrRelValue v;
+    AbsOrRelValue ct;
+};
+
+struct RequestChannelOutput {
+    AbsOrRelValue r;
+    AbsOrRelValue g;
+    AbsOrRelValue b;
+    AbsOrRelValue ww;
+    AbsOrRelValue cw;
+};
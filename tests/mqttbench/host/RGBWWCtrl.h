@@ -0,0 +1,13 @@
+#pragma once
+
+// Minimal stand-ins for the firmware environment, just enough to build
+// app/mqttpayload.cpp and app/colorframe.cpp on the host.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <mqttpayload.h>
+#include <colorframe.h>
@@ -0,0 +1,161 @@
+/*
+ * Host benchmark of the MQTT payloads published at the LED step rate.
+ *
+ * Counts heap allocations and time per publish for the color, clock and
+ * clock status payloads formatted with MqttPayload. For comparison the
+ * previous way is replayed with std::string: the topic concatenated from
+ * topic base, id and suffix and the payload serialized into a fresh string
+ * on every publish.
+ *
+ * For the binary color sync the slave side is measured as well: frames
+ * decoded per second, the part of a received color message that replaces
+ * the JSON parsing.
+ *
+ * Build and run from the repository root:
+ *
+ *   g++ -std=c++17 -O2 -Itests/mqttbench/host -Iinclude \
+ *       tests/mqttbench/mqttbench.cpp app/mqttpayload.cpp app/colorframe.cpp -o mqttbench
+ *   ./mqttbench
+ */
+
+#include <RGBWWCtrl.h>
+
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+size_t allocations = 0;
+
+const char* topicBase = "home/";
+const char* deviceId = "rgbww_5ccf7f0a1b2c";
+const unsigned iterations = 200000;
+
+// keeps the compiler from dropping the work
+volatile size_t sink = 0;
+
+struct Result {
+    double allocsPerPublish;
+    double nsPerPublish;
+};
+
+template<typename F>
+Result measure(F publish) {
+    const size_t before = allocations;
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned i=0; i < iterations; ++i)
+        publish(i);
+    const auto end = std::chrono::steady_clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return { static_cast<double>(allocations - before) / iterations, ns / iterations };
+}
+
+std::string buildTopic(const char* suffix) {
+    std::string topic = topicBase;
+    topic += std::string(deviceId) + "/";
+    return topic + suffix;
+}
+
+// the previous HSV publish, with ArduinoJson's output replaced by string appends
+void publishHsvStrings(unsigned i) {
+    const std::string topic = buildTopic("color");
+    std::string msg = "{\"hsv\":{\"h\":";
+    msg += std::to_string(i % 628 / 100.0f);
+    msg += ",\"s\":" + std::to_string(1.0f);
+    msg += ",\"v\":" + std::to_string((i % 1000) / 1000.0f);
+    msg += ",\"ct\":" + std::to_string(2700);
+    msg += "},\"t\":0,\"cmd\":\"solid\"}";
+    sink += topic.size() + msg.size();
+}
+
+void publishClockStrings(unsigned i) {
+    const std::string topic = buildTopic("clock");
+    std::string msg;
+    msg += std::to_string(i * 1500u);
+    sink += topic.size() + msg.size();
+}
+
+void print(const char* name, const Result& result) {
+    printf("%-28s %8.2f %10.1f\n", name, result.allocsPerPublish, result.nsPerPublish);
+}
+
+}
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+int main() {
+    // interned once per connection like AppMqttClient::connect()
+    const std::string topicColor = buildTopic("color");
+    const std::string topicClock = buildTopic("clock");
+    MqttPayload payload;
+
+    printf("%-28s %8s %10s\n", "publish", "allocs", "ns");
+    print("hsv strings", measure(publishHsvStrings));
+    print("hsv payload", measure([&](unsigned i) {
+        payload.setHsv(i % 628 / 100.0f, 1.0f, (i % 1000) / 1000.0f, 2700);
+        sink += topicColor.size() + payload.length();
+    }));
+    print("raw payload", measure([&](unsigned i) {
+        payload.setRaw(i % 1024, 1023 - i % 1024, 0, 512, 0);
+        sink += topicColor.size() + payload.length();
+    }));
+    print("clock strings", measure(publishClockStrings));
+    print("clock payload", measure([&](unsigned i) {
+        payload.setUint(i * 1500u);
+        sink += topicClock.size() + payload.length();
+    }));
+    print("clock offset payload", measure([&](unsigned i) {
+        payload.setInt(static_cast<int>(i % 20) - 10);
+        sink += payload.length();
+    }));
+
+    ColorFrame frame;
+    frame.mode = ColorFrame::Hsv;
+    frame.values[3] = 2700;
+    uint8_t buffer[ColorFrame::Size];
+    print("hsv frame", measure([&](unsigned i) {
+        frame.values[0] = i % 6144;
+        frame.values[2] = i % 1024;
+        frame.step = i;
+        frame.encode(buffer);
+        sink += buffer[6];
+    }));
+
+    // slave side, frames as received
+    std::vector<uint8_t> frames(1024 * ColorFrame::Size);
+    for (unsigned i=0; i < 1024; ++i) {
+        frame.values[0] = i;
+        frame.step = i;
+        frame.encode(&frames[i * ColorFrame::Size]);
+    }
+    unsigned decoded = 0;
+    const Result decode = measure([&](unsigned i) {
+        ColorFrame received;
+        if (received.decode(&frames[(i % 1024) * ColorFrame::Size], ColorFrame::Size))
+            ++decoded;
+        sink += received.values[0];
+    });
+    print("frame decode (slave)", decode);
+    printf("\nframe decode: %.0f messages/s per slave, %u of %u valid\n",
+            1e9 / decode.nsPerPublish, decoded, iterations);
+
+    payload.setHsv(3.14159f, 0.5f, 0.25f, 2700);
+    printf("payload bytes: json %zu, frame %zu\n", payload.length(), ColorFrame::Size);
+    printf("example: %s\n", payload.c_str());
+    return payload.isOverflowed() ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * Host benchmark of the output stage run on every LED step.
+ *
+ * Measures the time per step for the brightness correction the library
+ * applied per channel, for dimming curves evaluated directly, and for the
+ * OutputLut kernels which fold both into one interpolated lookup. The
+ * table results are compared against the directly evaluated curves to
+ * show the interpolation error in PWM steps.
+ *
+ * The tables cost more per step than the library's brightness correction
+ * they replace. They only gain against evaluating a non-linear dimming
+ * curve on every step, which is what the curves would cost without them.
+ *
+ * Build and run from the repository root:
+ *
+ *   g++ -std=c++17 -O2 -Itests/host -Iinclude tests/outputbench/outputbench.cpp \
+ *       app/outputlut.cpp app/calibration.cpp -o outputbench
+ *   ./outputbench
+ */
+
+#include <RGBWWCtrl.h>
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const unsigned iterations = 2000000;
+const int brightness[OutputLut::NumChannels] = { 100, 85, 70, 100, 90 };
+const int gammaPercent = 220;
+
+// keeps the compiler from dropping the work
+volatile int sink = 0;
+
+// inputs cycle through the whole range, different per channel
+std::vector<ChannelOutput> makeInputs() {
+    std::vector<ChannelOutput> inputs(4096);
+    for (unsigned i=0; i < inputs.size(); ++i) {
+        inputs[i].r = (i * 7) % (RGBWW_CALC_MAXVAL + 1);
+        inputs[i].g = (i * 13) % (RGBWW_CALC_MAXVAL + 1);
+        inputs[i].b = (i * 29) % (RGBWW_CALC_MAXVAL + 1);
+        inputs[i].ww = (i * 3) % (RGBWW_CALC_MAXVAL + 1);
+        inputs[i].cw = (i * 17) % (RGBWW_CALC_MAXVAL + 1);
+    }
+    return inputs;
+}
+
+template<typename F>
+double measure(const std::vector<ChannelOutput>& inputs, F stage) {
+    // one untimed pass warms up caches and branch predictors
+    for (const ChannelOutput& input : inputs) {
+        ChannelOutput output = input;
+        stage(output);
+        sink += output.r;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned i=0; i < iterations; ++i) {
+        ChannelOutput output = inputs[i % inputs.size()];
+        stage(output);
+        sink += output.r + output.g + output.b + output.ww + output.cw;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+// per channel percentage like RGBWWColorUtils::correctBrightness()
+void correctBrightness(ChannelOutput& output) {
+    output.r = output.r * brightness[0] / 100;
+    output.g = output.g * brightness[1] / 100;
+    output.b = output.b * brightness[2] / 100;
+    output.ww = output.ww * brightness[3] / 100;
+    output.cw = output.cw * brightness[4] / 100;
+}
+
+float cie1931(float lightness) {
+    const float l = lightness * 100.0f;
+    if (l <= 8.0f)
+        return l / 903.3f;
+    const float y = (l + 16.0f) / 116.0f;
+    return y * y * y;
+}
+
+// the curve without tables, evaluated per channel and step
+template<typename Curve>
+int direct(int value, int percent, Curve curve) {
+    const float y = curve(float(value) / RGBWW_CALC_MAXVAL);
+    return static_cast<int>(y * percent / 100.0f * RGBWW_CALC_MAXVAL + 0.5f);
+}
+
+template<typename Curve>
+void directCurve(ChannelOutput& output, Curve curve) {
+    output.r = direct(output.r, brightness[0], curve);
+    output.g = direct(output.g, brightness[1], curve);
+    output.b = direct(output.b, brightness[2], curve);
+    output.ww = direct(output.ww, brightness[3], curve);
+    output.cw = direct(output.cw, brightness[4], curve);
+}
+
+// largest difference between table and curve over all inputs, in PWM steps
+template<typename Curve>
+double maxError(const OutputLut& lut, Curve curve) {
+    double worst = 0;
+    for (int v=0; v <= RGBWW_CALC_MAXVAL; ++v) {
+        for (unsigned ch=0; ch < OutputLut::NumChannels; ++ch) {
+            const double exact = curve(float(v) / RGBWW_CALC_MAXVAL) * brightness[ch] / 100.0 * RGBWW_CALC_MAXVAL;
+            const double table = double(lut.lookup(ch, v)) / (1 << OutputLut::FracBits);
+            worst = std::max(worst, std::fabs(table - exact));
+        }
+    }
+    return worst;
+}
+
+void print(const char* name, double ns) {
+    printf("%-32s %8.1f\n", name, ns);
+}
+
+}
+
+int main() {
+    const std::vector<ChannelOutput> inputs = makeInputs();
+    const auto gammaCurve = [](float x) { return powf(x, gammaPercent / 100.0f); };
+    const auto linearCurve = [](float x) { return x; };
+
+    OutputLut linear, cie, gammaLut;
+    linear.build(brightness, OutputLut::Curve::Linear, gammaPercent);
+    cie.build(brightness, OutputLut::Curve::Cie1931, gammaPercent);
+    gammaLut.build(brightness, OutputLut::Curve::Gamma, gammaPercent);
+
+    OutputLut dithered;
+    dithered.build(brightness, OutputLut::Curve::Cie1931, gammaPercent);
+    dithered.setDithering(0x1f);
+
+    const float rgb[9] = { 0.95f, 0.05f, 0.0f, 0.02f, 0.9f, 0.08f, 0.0f, 0.03f, 0.97f };
+    const float white[4] = { 1.0f, 0.0f, 0.05f, 0.95f };
+    ColorCalibration calibration;
+    calibration.build(rgb, white);
+
+    const OutputLut::Kernel rgbKernel = OutputLut::kernelFor(RGB);
+    const OutputLut::Kernel fullKernel = OutputLut::kernelFor(RGBWWCW);
+
+    printf("%-32s %8s\n", "stage per step", "ns");
+    const double libraryNs = measure(inputs, correctBrightness);
+    const double cieDirectNs = measure(inputs, [&](ChannelOutput& o) { directCurve(o, cie1931); });
+    const double gammaDirectNs = measure(inputs, [&](ChannelOutput& o) { directCurve(o, gammaCurve); });
+    const double cieTableNs = measure(inputs, [&](ChannelOutput& o) { fullKernel(cie, o); });
+    print("brightness (library)", libraryNs);
+    print("brightness + cie1931 direct", cieDirectNs);
+    print("brightness + gamma direct", gammaDirectNs);
+    print("table linear RGBWWCW", measure(inputs, [&](ChannelOutput& o) { fullKernel(linear, o); }));
+    print("table cie1931 RGBWWCW", cieTableNs);
+    print("table cie1931 RGB", measure(inputs, [&](ChannelOutput& o) { rgbKernel(cie, o); }));
+    print("table gamma RGBWWCW", measure(inputs, [&](ChannelOutput& o) { fullKernel(gammaLut, o); }));
+    print("table cie1931 dithered", measure(inputs, [&](ChannelOutput& o) { fullKernel(dithered, o); }));
+    print("calibration + table cie1931", measure(inputs, [&](ChannelOutput& o) {
+        calibration.apply(o);
+        fullKernel(cie, o);
+    }));
+
+    // no per step gain over the library: the gain is against curves evaluated per step
+    printf("\ncie1931 table vs library brightness: %.1fx the cost\n", cieTableNs / libraryNs);
+    printf("cie1931 table vs curve evaluated per step: %.1fx the cost\n", cieTableNs / cieDirectNs);
+
+    printf("\n%-32s %8s\n", "table error", "PWM LSB");
+    printf("%-32s %8.3f\n", "linear", maxError(linear, linearCurve));
+    printf("%-32s %8.3f\n", "cie1931", maxError(cie, cie1931));
+    printf("%-32s %8.3f\n", "gamma 2.2", maxError(gammaLut, gammaCurve));
+    return 0;
+}
@@ -0,0 +1,272 @@
+/*
+ * Host replay of stored animation sequences.
+ *
+ * Programs are assembled in the bytecode of SequencePlayer, stored in an
+ * in-memory filesystem and played with the real player and transitions,
+ * one process() call per LED step like APPLedCtrl::updateLed(). Each case
+ * checks the colors written per step, the step count and the filesystem
+ * calls made while playing.
+ *
+ * Build and run from the repository root:
+ *
+ *   g++ -std=c++17 -O2 -Itests/host -Iinclude tests/seqreplay/seqreplay.cpp \
+ *       app/sequence.cpp app/transition.cpp app/easing.cpp app/oklab.cpp -o seqreplay
+ *   ./seqreplay [--trace]
+ *
+ * Exits with 1 if any check fails. --trace prints the color of every step.
+ */
+
+#include <RGBWWCtrl.h>
+
+#include <vector>
+
+namespace {
+
+bool trace = false;
+unsigned failures = 0;
+
+// writes instructions the way JsonProcessor::compileSequence() does
+class Program {
+public:
+    Program() {
+        SequencePlayer::writeHeader(_code);
+    }
+
+    Program& fadeHsv(int h, int s, int v, int ct, uint32_t ms) {
+        op(SequencePlayer::FadeHsv);
+        u16(h).u16(s).u16(v).u16(ct);
+        return u32(ms);
+    }
+
+    Program& fadeRaw(int r, int g, int b, int ww, int cw, uint32_t ms) {
+        op(SequencePlayer::FadeRaw);
+        u16(r).u16(g).u16(b).u16(ww).u16(cw);
+        return u32(ms);
+    }
+
+    // compiled form of a step without fade: set at once, then kept for the ramp time
+    Program& solidHsv(int h, int s, int v, int ct, uint32_t ms) {
+        fadeHsv(h, s, v, ct, 0);
+        return hold(ms);
+    }
+
+    Program& hold(uint32_t ms) { return op(SequencePlayer::Hold).u32(ms); }
+    Program& loop(uint16_t count) { return op(SequencePlayer::Loop).u16(count); }
+    Program& endLoop() { return op(SequencePlayer::EndLoop); }
+    Program& channels(ChannelMask mask) { return op(SequencePlayer::Channels).u16(mask); }
+    Program& ease(uint8_t curve) { return op(SequencePlayer::Ease).u8(curve); }
+    Program& end() { return op(SequencePlayer::End); }
+
+    const String& code() const { return _code; }
+
+private:
+    Program& op(uint8_t opcode) { return u8(opcode); }
+
+    Program& u8(uint8_t value) {
+        _code += static_cast<char>(value);
+        return *this;
+    }
+
+    Program& u16(uint16_t value) { return u8(value).u8(value >> 8); }
+    Program& u32(uint32_t value) { return u16(value).u16(value >> 16); }
+
+    String _code;
+};
+
+struct Replay {
+    std::vector<HSVCT> colors;
+    std::vector<ChannelOutput> outputs;
+    HostFs::Stats fs;
+    unsigned steps = 0;
+    bool finished = false;
+};
+
+// plays until the sequence ends or maxSteps LED steps have passed
+Replay play(const char* name, const Program& program, unsigned maxSteps = 10000) {
+    String msg;
+    Replay replay;
+    if (!SequencePlayer::store(name, program.code(), msg)) {
+        printf("store %s failed: %s\n", name, msg.c_str());
+        return replay;
+    }
+
+    RGBWWLed led;
+    SequencePlayer player;
+    HostFs::stats = HostFs::Stats();
+    if (!player.start(name))
+        return replay;
+
+    while (replay.steps < maxSteps) {
+        if (!player.process(led)) {
+            replay.finished = true;
+            break;
+        }
+        ++replay.steps;
+        replay.colors.push_back(led.getCurrentColor());
+        replay.outputs.push_back(led.getCurrentOutput());
+
+        if (trace) {
+            const HSVCT& c = led.getCurrentColor();
+            const ChannelOutput& o = led.getCurrentOutput();
+            printf("%s,%u,%d,%d,%d,%d,%d,%d,%d,%d,%d\n", name, replay.steps, c.h, c.s, c.v, c.ct, o.r, o.g, o.b, o.ww, o.cw);
+        }
+    }
+    player.stop();
+    replay.fs = HostFs::stats;
+    return replay;
+}
+
+void check(const char* name, bool ok) {
+    printf("%-44s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok)
+        ++failures;
+}
+
+void rawFade() {
+    const Replay r = play("raw_fade", Program().fadeRaw(1000, 0, 0, 0, 500, 200).end());
+    bool monotonic = true;
+    for (size_t i=1; i < r.outputs.size(); ++i)
+        monotonic &= r.outputs[i].r >= r.outputs[i - 1].r;
+
+    check("raw fade: 200 ms take 10 steps", r.finished && r.steps == 10);
+    check("raw fade: rises monotonic to the target", monotonic && r.outputs.back().r == 1000 && r.outputs.back().cw == 500);
+}
+
+void solidStep() {
+    const Replay r = play("solid", Program().solidHsv(0, 1023, 800, 0, 100).fadeHsv(0, 1023, 0, 0, 100).end());
+    bool held = true;
+    for (unsigned i=0; i < 6; ++i)
+        held &= r.colors[i].v == 800;
+
+    check("solid step: set at the first step", !r.colors.empty() && r.colors[0].v == 800);
+    check("solid step: kept for the ramp time", held && r.colors[6].v < 800);
+    check("solid step: next fade reaches its target", r.finished && r.colors.back().v == 0);
+}
+
+void channelMask() {
+    Program program;
+    program.fadeHsv(1000, 1023, 1023, 2700, 0)
+            .channels(channelBit(CtrlChannel::Val))
+            .fadeHsv(3000, 0, 200, 6000, 100)
+            .end();
+    const Replay r = play("channels", program);
+    const HSVCT& last = r.colors.back();
+    check("channel mask: only the value fades", r.finished && last.v == 200 && last.h == 1000 && last.s == 1023 && last.ct == 2700);
+}
+
+void hueDirection() {
+    // the transitions behind sequences and JSON eased fades, direction as in "d"
+    HSVCT from, to;
+    from.h = 100;
+    to.h = 600;
+    from.s = to.s = from.v = to.v = RGBWW_CALC_MAXVAL;
+    int hue[2][2];
+    for (int direction=0; direction < 2; ++direction) {
+        RGBWWLed led;
+        Transition transition;
+        transition.startHsv(from, to, 200, Easing::Linear, channelBit(CtrlChannel::Hue), direction);
+        transition.process(led);
+        hue[direction][0] = led.getCurrentColor().h;
+        while (transition.process(led)) {}
+        hue[direction][1] = led.getCurrentColor().h;
+    }
+    check("hue direction: 1 takes the shorter way", hue[1][0] > 100 && hue[1][0] < 600 && hue[1][1] == 600);
+    check("hue direction: 0 goes the other way round", hue[0][0] > 600 && hue[0][1] == 600);
+}
+
+void easedFade() {
+    const Replay linear = play("linear", Program().fadeRaw(1000, 0, 0, 0, 0, 400).end());
+    const Replay eased = play("eased", Program().ease(Easing::In).fadeRaw(1000, 0, 0, 0, 0, 400).end());
+    check("easing: slow start below the linear fade", eased.outputs[4].r < linear.outputs[4].r);
+    check("easing: same end point", eased.outputs.back().r == 1000 && eased.steps == linear.steps);
+}
+
+void loops() {
+    // 3 x (2 fade steps + 2 hold steps)
+    const Replay counted = play("loop3", Program().loop(3).fadeRaw(0, 1023, 0, 0, 0, 40).hold(40).endLoop().end());
+    check("loop: 3 passes take 12 steps", counted.finished && counted.steps == 12);
+
+    Program nested;
+    nested.loop(2).loop(3).hold(20).endLoop().hold(20).endLoop().end();
+    const Replay n = play("nested", nested);
+    check("loop: nested 2 x (3 + 1) steps", n.finished && n.steps == 8);
+
+    const Replay forever = play("forever", Program().loop(0).fadeRaw(1023, 0, 0, 0, 0, 20).fadeRaw(0, 0, 0, 0, 0, 20).endLoop().end(), 1000);
+    check("loop: count 0 repeats forever", !forever.finished && forever.steps == 1000);
+
+    // untimed instructions only, the budget must hand back the LED timer
+    const Replay empty = play("spin", Program().loop(0).channels(0).endLoop().end(), 100);
+    check("loop: untimed loop does not block a step", !empty.finished && empty.steps == 100);
+}
+
+void fileAccess() {
+    // longer than the read window, so the loop jumps back across a refill
+    Program program;
+    program.loop(25);
+    for (int i=0; i < 12; ++i)
+        program.fadeRaw(i * 50, 0, 1023 - i * 50, 0, 0, 20);
+    program.endLoop().end();
+
+    const unsigned instructions = 1 + 25 * 13 + 1;
+    const Replay r = play("window", program);
+    check("window: program larger than the window", program.code().length() > SequencePlayer::WindowSize);
+    check("window: all 300 fades played", r.finished && r.steps == 300 && r.outputs.back().r == 550);
+    check("window: file opened once", r.fs.opens == 1);
+    check("window: fewer reads than instructions", r.fs.reads * 4 < instructions);
+    printf("  %u instructions: %u opens, %u seeks, %u reads (one of each per instruction before)\n",
+            instructions, r.fs.opens, r.fs.seeks, r.fs.reads);
+}
+
+void validation() {
+    String msg;
+    String truncated = Program().hold(20).end().code();
+    truncated.pop_back();
+    truncated.pop_back();
+    check("validate: truncated instruction", !SequencePlayer::validate(truncated, msg));
+    check("validate: missing end", !SequencePlayer::validate(Program().hold(20).code(), msg));
+    check("validate: unbalanced loop", !SequencePlayer::validate(Program().loop(2).hold(20).end().code(), msg));
+    check("validate: unknown easing", !SequencePlayer::validate(Program().ease(Easing::NumCurves).end().code(), msg));
+    check("validate: valid program", SequencePlayer::validate(Program().loop(2).hold(20).endLoop().end().code(), msg));
+
+    SequencePlayer player;
+    check("start: unknown sequence", !player.start("missing"));
+    check("start: invalid name", !player.start("../config"));
+
+    // a failed start keeps the running sequence, also across a window refill
+    Program program;
+    for (int i=0; i < 20; ++i)
+        program.fadeRaw(i * 50, 0, 0, 0, 0, 20);
+    SequencePlayer::store("running", program.end().code(), msg);
+    RGBWWLed led;
+    unsigned steps = 0;
+    player.start("running");
+    for (; steps < 5 && player.process(led); ++steps) {}
+    check("start: failed start keeps the running sequence", !player.start("missing") && player.isActive());
+    while (player.process(led))
+        ++steps;
+    check("start: running sequence plays to its end", steps == 20 && led.getCurrentOutput().r == 950);
+}
+
+}
+
+int main(int argc, char** argv) {
+    for (int i=1; i < argc; ++i) {
+        if (strcmp(argv[i], "--trace") == 0)
+            trace = true;
+    }
+
+    if (trace)
+        printf("sequence,step,h,s,v,ct,r,g,b,ww,cw\n");
+
+    rawFade();
+    solidStep();
+    channelMask();
+    hueDirection();
+    easedFade();
+    loops();
+    fileAccess();
+    validation();
+
+    printf("%u checks failed\n", failures);
+    return failures ? 1 : 0;
+}
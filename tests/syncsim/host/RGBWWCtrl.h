@@ -0,0 +1,42 @@
+#pragma once
+
+// Minimal stand-ins for the firmware environment, just enough to build
+// app/stepsync.cpp and app/clockfilter.cpp on the host.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#define RGBWW_MINTIMEDIFF 20
+#define RGBWW_MINTIMEDIFF_US (RGBWW_MINTIMEDIFF * 1000)
+#define RGBWW_UPDATEFREQUENCY (1000 / RGBWW_MINTIMEDIFF)
+
+#define debug_d(...)
+#define debug_i(...)
+#define debug_w(...)
+
+// persistence is not simulated, every controller starts without a learned drift.
+// Saves are only counted, to see how often a controller would write the flash.
+template<size_t Capacity>
+class StaticJsonDocument {
+public:
+    struct Value {
+        Value& operator=(int) { return *this; }
+        int operator|(int defaultValue) const { return defaultValue; }
+    };
+    Value operator[](const char*) { return Value(); }
+};
+
+namespace Json {
+    inline unsigned saveCount = 0;
+
+    template<class Doc> bool loadFromFile(Doc&, const char*) { return false; }
+    template<class Doc> bool saveToFile(Doc&, const char*) {
+        ++saveCount;
+        return true;
+    }
+}
+
+#include <stepsync.h>
+#include <clockfilter.h>
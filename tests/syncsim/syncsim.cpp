@@ -0,0 +1,355 @@
+/*
+ * Deterministic host simulation of the master clock synchronization.
+ *
+ * A virtual master publishes its step counter like AppMqttClient::publishClock()
+ * does, or like ClockUdp with --transport udp. The messages travel through a
+ * simulated network with latency, jitter, delay spikes and loss to N virtual
+ * controllers. Each controller runs its LED timer with its own crystal drift
+ * and timer jitter and feeds the received clock into the real StepSync,
+ * clamping the interval like APPLedCtrl::onMasterClock(). UDP slaves filter
+ * the packets with the real ClockFilter first.
+ *
+ * With --algorithm old the slaves run the steering StepSync used before the
+ * drift estimation instead, for comparison. The summary lists the drift
+ * estimate and how often a slave would have saved it to flash.
+ *
+ * Build and run from the repository root:
+ *
+ *   g++ -std=c++17 -O2 -Itests/syncsim/host -Iinclude \
+ *       tests/syncsim/syncsim.cpp app/stepsync.cpp app/clockfilter.cpp -o syncsim
+ *   ./syncsim --slaves 30 --drift 150 --latency 20 --latency-jitter 40 --loss 2
+ *   ./syncsim --slaves 30 --drift 150 --transport udp --latency 2 --latency-jitter 3 \
+ *       --spike-percent 10 --spike-ms 100
+ *   ./syncsim --slaves 5 --duration 86400 --report 600 --algorithm old
+ *
+ * Output is CSV with the phase error in ms of every slave over time,
+ * followed by a summary per slave. Same options and seed, same output.
+ */
+
+#include <RGBWWCtrl.h>
+
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    unsigned slaves = 5;
+    double driftPpm = 100;         // crystal drift of the slaves is uniform in +-driftPpm
+    double timerJitterUs = 200;    // per LED step
+    double latencyMs = 20;         // network delivery latency
+    double latencyJitterMs = 40;   // additional uniform latency
+    double lossPercent = 0;
+    double spikePercent = 0;       // share of messages with an additional delay spike
+    double spikeMs = 0;            // spikes are uniform up to this
+    bool udp = false;
+    unsigned intervalS = 30;       // sync.clock_master_interval
+    unsigned durationS = 3600;
+    unsigned reportS = 60;
+    int masterRestartS = -1;       // master reboots without a reset message
+    bool oldAlgorithm = false;
+    uint32_t seed = 1;
+};
+
+// deterministic on every platform, unlike the std distributions
+class Random {
+public:
+    explicit Random(uint32_t seed) : _gen(seed) {}
+    double uniform() { return _gen() / 4294967296.0; }
+    double uniform(double lo, double hi) { return lo + (hi - lo) * uniform(); }
+
+private:
+    std::mt19937 _gen;
+};
+
+// the steering of StepSync before the drift estimation: the interval is scaled by a
+// proportional term on the accumulated offset, averaged with its previous value
+class SteeringSync {
+public:
+    uint32_t onMasterClock(uint32_t stepsCurrent, uint32_t stepsMaster) {
+        uint32_t nextInt = RGBWW_MINTIMEDIFF_US;
+        if (!_firstMasterSync) {
+            const int diff = stepsCurrent - _stepsSyncLast;
+            const int masterDiff = stepsMaster - _stepsSyncMasterLast;
+            _catchupOffset += masterDiff - diff;
+
+            float curSteering = 1.0 - static_cast<float>(_catchupOffset) / masterDiff;
+            curSteering = std::min(std::max(curSteering, 0.5f), 1.5f);
+            _steering = 0.5f * _steering + 0.5f * curSteering;
+            nextInt *= _steering;
+        }
+
+        _stepsSyncMasterLast = stepsMaster;
+        _stepsSyncLast = stepsCurrent;
+        _firstMasterSync = false;
+        return nextInt;
+    }
+
+private:
+    uint32_t _stepsSyncMasterLast = 0;
+    uint32_t _stepsSyncLast = 0;
+    bool _firstMasterSync = true;
+    int _catchupOffset = 0;
+    float _steering = 1.0f;
+};
+
+struct Message {
+    int64_t deliverUs;
+    uint32_t steps;
+    uint32_t sendUs;
+    uint32_t stepUs;    // time into the master step, UDP only
+};
+
+struct Slave {
+    StepSync sync;
+    SteeringSync steering;
+    unsigned saves = 0;
+    double rate = 1.0;           // real duration of one timer microsecond
+    double lastStepUs = 0;
+    double nextStepUs = 0;
+    uint32_t steps = 0;
+    uint32_t intervalUs = RGBWW_MINTIMEDIFF_US;
+    std::deque<Message> inbox;
+    double clockOffsetUs = 0;    // local micros() at virtual time 0
+    ClockFilter filter;
+    int64_t lastSyncUs = -1;
+
+    // reference for the phase error, taken at the first received clock
+    bool synced = false;
+    double masterRef = 0;
+    double slaveRef = 0;
+
+    double maxError = 0;
+    double sumSquares = 0;
+    unsigned samples = 0;
+};
+
+class Master {
+public:
+    explicit Master(int64_t restartUs) : _restartUs(restartUs) {}
+
+    uint32_t stepsAt(int64_t us) const {
+        return static_cast<uint32_t>((us - originAt(us)) / RGBWW_MINTIMEDIFF_US);
+    }
+
+    uint32_t stepUsAt(int64_t us) const {
+        return static_cast<uint32_t>((us - originAt(us)) % RGBWW_MINTIMEDIFF_US);
+    }
+
+    // master steps including the fraction of the running one, continued over a restart
+    double phaseAt(int64_t us) const {
+        return static_cast<double>(us) / RGBWW_MINTIMEDIFF_US;
+    }
+
+private:
+    int64_t originAt(int64_t us) const {
+        return (_restartUs >= 0 && us >= _restartUs) ? _restartUs : 0;
+    }
+
+    int64_t _restartUs;
+};
+
+void usage() {
+    printf("usage: syncsim [--slaves n] [--drift ppm] [--timer-jitter us] [--latency ms]\n"
+           "               [--latency-jitter ms] [--loss percent] [--spike-percent percent]\n"
+           "               [--spike-ms ms] [--transport mqtt|udp] [--interval s]\n"
+           "               [--duration s] [--report s] [--master-restart s] [--seed n]\n"
+           "               [--algorithm old|new]\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& opt) {
+    for (int i=1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        const char* value = argv[++i];
+
+        if (arg == "--slaves")
+            opt.slaves = std::max(atoi(value), 1);
+        else if (arg == "--drift")
+            opt.driftPpm = atof(value);
+        else if (arg == "--timer-jitter")
+            opt.timerJitterUs = atof(value);
+        else if (arg == "--latency")
+            opt.latencyMs = atof(value);
+        else if (arg == "--latency-jitter")
+            opt.latencyJitterMs = atof(value);
+        else if (arg == "--loss")
+            opt.lossPercent = atof(value);
+        else if (arg == "--spike-percent")
+            opt.spikePercent = atof(value);
+        else if (arg == "--spike-ms")
+            opt.spikeMs = atof(value);
+        else if (arg == "--transport" && (strcmp(value, "mqtt") == 0 || strcmp(value, "udp") == 0))
+            opt.udp = (strcmp(value, "udp") == 0);
+        else if (arg == "--interval")
+            opt.intervalS = std::max(atoi(value), 1);
+        else if (arg == "--duration")
+            opt.durationS = std::max(atoi(value), 1);
+        else if (arg == "--report")
+            opt.reportS = std::max(atoi(value), 1);
+        else if (arg == "--master-restart")
+            opt.masterRestartS = atoi(value);
+        else if (arg == "--seed")
+            opt.seed = strtoul(value, nullptr, 10);
+        else if (arg == "--algorithm" && (strcmp(value, "old") == 0 || strcmp(value, "new") == 0))
+            opt.oldAlgorithm = (strcmp(value, "old") == 0);
+        else
+            return false;
+    }
+    return true;
+}
+
+// same clamping as APPLedCtrl::onMasterClock()
+uint32_t clampInterval(uint32_t interval) {
+    return std::min(std::max(interval, RGBWW_MINTIMEDIFF_US / 2u), static_cast<uint32_t>(RGBWW_MINTIMEDIFF_US * 1.5));
+}
+
+double slavePhase(const Slave& slave, int64_t nowUs) {
+    return slave.steps + (nowUs - slave.lastStepUs) / (slave.nextStepUs - slave.lastStepUs);
+}
+
+// in ms, sub-step resolution so the transports can be compared
+double phaseError(const Slave& slave, const Master& master, int64_t nowUs) {
+    const double steps = (master.phaseAt(nowUs) - slave.masterRef) - (slavePhase(slave, nowUs) - slave.slaveRef);
+    return steps * RGBWW_MINTIMEDIFF;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        usage();
+        return 1;
+    }
+
+    Random rnd(opt.seed);
+    const int64_t durationUs = static_cast<int64_t>(opt.durationS) * 1000000;
+    const int64_t intervalUs = static_cast<int64_t>(opt.intervalS) * 1000000;
+    const int64_t reportUs = static_cast<int64_t>(opt.reportS) * 1000000;
+    Master master(opt.masterRestartS >= 0 ? static_cast<int64_t>(opt.masterRestartS) * 1000000 : -1);
+
+    std::vector<Slave> slaves(opt.slaves);
+    for (Slave& slave : slaves) {
+        slave.rate = 1.0 + rnd.uniform(-opt.driftPpm, opt.driftPpm) * 1e-6;
+        // devices are not powered up at the same instant
+        slave.nextStepUs = rnd.uniform(0, RGBWW_MINTIMEDIFF_US * 50);
+        slave.clockOffsetUs = rnd.uniform(0, 4294967296.0);
+    }
+
+    printf("time_s");
+    for (unsigned i=0; i < slaves.size(); ++i)
+        printf(",slave%u", i);
+    printf("\n");
+
+    // settling is excluded from the summary
+    const int64_t settleUs = std::min<int64_t>(durationUs / 2, 10 * intervalUs);
+    // like ClockUdp the master sends UDP packets every second
+    const int64_t publishUs = opt.udp ? 1000000 : intervalUs;
+    int64_t nextPublishUs = publishUs;
+    int64_t nextReportUs = reportUs;
+
+    for (int64_t now = 0; now <= durationUs; ) {
+        if (now == nextPublishUs) {
+            const uint32_t steps = master.stepsAt(now);
+            const uint32_t stepUs = master.stepUsAt(now);
+            for (Slave& slave : slaves) {
+                if (rnd.uniform() * 100 < opt.lossPercent)
+                    continue;
+                double latencyMs = opt.latencyMs + rnd.uniform(0, opt.latencyJitterMs);
+                if (rnd.uniform() * 100 < opt.spikePercent)
+                    latencyMs += rnd.uniform(0, opt.spikeMs);
+                const int64_t deliverUs = now + static_cast<int64_t>(latencyMs * 1000);
+                // keep the inbox ordered, a delayed message does not hold back later ones
+                auto pos = slave.inbox.end();
+                while (pos != slave.inbox.begin() && (pos - 1)->deliverUs > deliverUs)
+                    --pos;
+                slave.inbox.insert(pos, { deliverUs, steps, static_cast<uint32_t>(now), stepUs });
+            }
+            nextPublishUs += publishUs;
+        }
+
+        for (Slave& slave : slaves) {
+            while (slave.nextStepUs <= now) {
+                ++slave.steps;
+                slave.lastStepUs = slave.nextStepUs;
+                const double jitter = rnd.uniform(-opt.timerJitterUs, opt.timerJitterUs);
+                slave.nextStepUs += std::max(slave.intervalUs * slave.rate + jitter, 1.0);
+            }
+
+            while (!slave.inbox.empty() && slave.inbox.front().deliverUs <= now) {
+                const Message msg = slave.inbox.front();
+                slave.inbox.pop_front();
+                if (opt.udp) {
+                    // same selection as ClockUdp::onReceive()
+                    const uint32_t recvUs = static_cast<uint32_t>(static_cast<int64_t>(now / slave.rate + slave.clockOffsetUs));
+                    if (!slave.filter.onPacket(msg.sendUs, recvUs))
+                        continue;
+                    if (slave.lastSyncUs >= 0 && (now - slave.lastSyncUs) + 500000 < intervalUs)
+                        continue;
+                    slave.lastSyncUs = now;
+                }
+
+                if (!slave.synced) {
+                    slave.synced = true;
+                    slave.masterRef = master.phaseAt(now);
+                    slave.slaveRef = slavePhase(slave, now);
+                }
+                // like APPLedCtrl::onMasterClock() the UDP clock is steered with sub-step phase
+                const int32_t subStepUs = opt.udp ? static_cast<int32_t>(msg.stepUs) -
+                        static_cast<int32_t>((now - slave.lastStepUs) / slave.rate) : StepSync::NoSubStep;
+                const unsigned saves = Json::saveCount;
+                const uint32_t interval = opt.oldAlgorithm ? slave.steering.onMasterClock(slave.steps, msg.steps) :
+                        slave.sync.onMasterClock(slave.steps, msg.steps, subStepUs);
+                slave.intervalUs = clampInterval(interval);
+                slave.saves += Json::saveCount - saves;
+            }
+
+            if (slave.synced && now >= settleUs) {
+                const double err = std::fabs(phaseError(slave, master, now));
+                slave.maxError = std::max(slave.maxError, err);
+                slave.sumSquares += err * err;
+                ++slave.samples;
+            }
+        }
+
+        if (now == nextReportUs) {
+            printf("%lld", static_cast<long long>(now / 1000000));
+            for (const Slave& slave : slaves) {
+                if (slave.synced)
+                    printf(",%.1f", phaseError(slave, master, now));
+                else
+                    printf(",");
+            }
+            printf("\n");
+            nextReportUs += reportUs;
+        }
+
+        // advance to the next event, in 1 ms steps at most so every error sample sees the same grid
+        int64_t next = std::min(std::min(nextPublishUs, nextReportUs), now + 1000);
+        for (const Slave& slave : slaves) {
+            if (!slave.inbox.empty())
+                next = std::min(next, slave.inbox.front().deliverUs);
+        }
+        now = std::max(next, now + 1);
+    }
+
+    // the old algorithm has no drift estimate and no lock state
+    printf("\nslave,crystal_ppm,estimated_drift_ppm,locked,saves,max_error_ms,rms_error_ms\n");
+    for (unsigned i=0; i < slaves.size(); ++i) {
+        const Slave& slave = slaves[i];
+        const double rms = slave.samples ? std::sqrt(slave.sumSquares / slave.samples) : 0;
+        printf("%u,%.0f,", i, (slave.rate - 1.0) * 1e6);
+        if (opt.oldAlgorithm)
+            printf(",,");
+        else
+            printf("%d,%d,", slave.sync.getDrift(), slave.sync.isLocked());
+        printf("%u,%.1f,%.1f\n", slave.saves, slave.maxError, rms);
+    }
+    return 0;
+}